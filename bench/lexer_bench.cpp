@@ -0,0 +1,197 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+#include "semant.hpp"
+#include "assembler.hpp"
+
+/*
+ * Lexer throughput benchmark
+ * Builds multi-megabyte .asm and .tmd inputs shaped like compiler output
+ * and reports tokens/sec for each CharScanner path, plus reserved word lookup
+ * against a linear scan.
+ */
+
+static ErrorMsgs ems;
+
+static std::string make_asm(int target_bytes) {
+    std::string s;
+    int fun = 0;
+    while ((int)s.size() < target_bytes) {
+        s += "fun" + std::to_string(fun) + ":\n";
+        s += "    push    ebp\n    mov     ebp, esp\n    sub     esp, 36\n";
+        for (int i = 0; i < 8; i++) {
+            int off = -4 * (i + 1);
+            s += "    mov     eax, [ebp + " + std::to_string(off) + "]\n";
+            s += "    mov     ecx, 10\n";
+            s += "    imul    eax, ecx\n";
+            s += "    cmp     eax, ecx\n";
+            s += "    setl    al\n";
+            s += "    movzx   eax, al\n";
+            s += "    mov     [ebp + " + std::to_string(off) + "], eax\n";
+        }
+        s += "    je      _L" + std::to_string(fun) + "\n";
+        s += "    call    fun" + std::to_string(fun) + "\n";
+        s += "_L" + std::to_string(fun) + ":\n";
+        s += "    add     esp, 36\n    pop     ebp\n    ret\n";
+        fun++;
+    }
+    return s;
+}
+
+static std::string make_tmd(int target_bytes) {
+    std::string s;
+    int fun = 0;
+    while ((int)s.size() < target_bytes) {
+        s += "fun" + std::to_string(fun) + " :: (a: int, b: int) -> int {\n";
+        s += "    x: int = a * 10 + b\n";
+        s += "    while x > 0 and true {\n";
+        s += "        if x < 100 or false {\n            x = x - 1\n        } else {\n            x = x / 2\n        }\n";
+        s += "    }\n";
+        s += "    return x\n}\n";
+        fun++;
+    }
+    return s;
+}
+
+template <typename F>
+static double best_of(int runs, F f) {
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        if (d.count() < best) best = d.count();
+    }
+    return best;
+}
+
+static void bench_lexer(const char* name, const std::string& code, const KeywordTable& words) {
+    CharScanner::Isa isas[] = {CharScanner::Isa::Scalar, CharScanner::Isa::SSE2, CharScanner::Isa::AVX2};
+    double scalar_secs = 0.0;
+    for (CharScanner::Isa isa: isas) {
+        if (!CharScanner::supported(isa)) {
+            printf("%-6s lex   %-6s not supported on this CPU\n", name, CharScanner::isa_name(isa));
+            continue;
+        }
+
+        size_t count = 0;
+        double secs = best_of(5, [&]() {
+            SourceBuffer source;
+            source.assign(code);
+            Lexer l;
+            l.set_scanner(CharScanner::create(isa));
+            l.init(source, words, ems);
+            count = 1;
+            while (l.next().type != T_EOF) count++;
+        });
+        if (isa == CharScanner::Isa::Scalar) scalar_secs = secs;
+
+        printf("%-6s lex   %-6s %6.2f MB  %9zu tokens  %8.3f ms  %7.2f Mtokens/s  %7.2f MB/s  (%.2fx scalar)\n",
+               name, CharScanner::isa_name(isa), code.size() / 1e6, count, secs * 1e3,
+               count / secs / 1e6, code.size() / secs / 1e6, scalar_secs / secs);
+    }
+}
+
+//boundary scanning alone: walk the buffer run by run without building tokens
+static void bench_scan(const char* name, const std::string& code) {
+    CharScanner::Isa isas[] = {CharScanner::Isa::Scalar, CharScanner::Isa::SSE2, CharScanner::Isa::AVX2};
+    double scalar_secs = 0.0;
+    for (CharScanner::Isa isa: isas) {
+        if (!CharScanner::supported(isa)) continue;
+
+        CharScanner sc = CharScanner::create(isa);
+        volatile size_t sink = 0;
+        double secs = best_of(5, [&]() {
+            size_t n = code.size();
+            size_t i = 0;
+            size_t runs = 0;
+            sc.reset(code.data(), n);
+            while (i < n) {
+                size_t k = sc.run(i, CharScanner::SPACE);
+                if (k == 0) k = sc.run(i, CharScanner::WORD);
+                if (k == 0) k = 1;
+                i += k;
+                runs++;
+            }
+            sink = runs;
+        });
+        if (isa == CharScanner::Isa::Scalar) scalar_secs = secs;
+
+        printf("%-6s scan  %-6s %8.3f ms  %7.2f MB/s  (%.2fx scalar)\n",
+               name, CharScanner::isa_name(isa), secs * 1e3, code.size() / secs / 1e6, scalar_secs / secs);
+    }
+}
+
+static void bench_lookup(const char* name, const std::string& code, const KeywordTable& words) {
+    SourceBuffer source;
+    source.assign(code);
+    Lexer l;
+    l.init(source, words, ems);
+    std::vector<struct Token> tokens;
+    do {
+        tokens.push_back(l.next());
+    } while (tokens.back().type != T_EOF);
+
+    //reference: linear scan the way the lexer used to recognize reserved words
+    std::vector<ReservedWordNew> linear;
+    for (const ReservedWordNew& rw: words.m_slots) {
+        if (rw.m_string.size() > 0) linear.push_back(rw);
+    }
+
+    std::vector<std::pair<const char*, int>> lexemes;
+    for (const struct Token& t: tokens) {
+        if (t.type != T_EOF && (t.type == T_IDENTIFIER || words.find(source.start(t), t.len) != T_IDENTIFIER)) {
+            lexemes.push_back({source.start(t), t.len});
+        }
+    }
+
+    volatile int sink = 0;
+    double linear_secs = best_of(5, [&]() {
+        int acc = 0;
+        for (const std::pair<const char*, int>& p: lexemes) {
+            enum TokenType tt = T_IDENTIFIER;
+            for (const ReservedWordNew& rw: linear) {
+                if (int(rw.m_string.size()) == p.second && strncmp(rw.m_string.data(), p.first, p.second) == 0) {
+                    tt = rw.m_token_type;
+                    break;
+                }
+            }
+            acc += tt;
+        }
+        sink = acc;
+    });
+
+    double hash_secs = best_of(5, [&]() {
+        int acc = 0;
+        for (const std::pair<const char*, int>& p: lexemes) {
+            acc += words.find(p.first, p.second);
+        }
+        sink = acc;
+    });
+
+    printf("%-6s words %9zu lookups  linear %8.3f ms  perfect hash %8.3f ms  (%.1fx)\n",
+           name, lexemes.size(), linear_secs * 1e3, hash_secs * 1e3, linear_secs / hash_secs);
+}
+
+int main(int argc, char** argv) {
+    int mb = argc > 1 ? atoi(argv[1]) : 8;
+    std::string assembly = make_asm(mb * 1000000);
+    std::string tamarind = make_tmd(mb * 1000000);
+
+    bench_lexer("asm", assembly, Assembler::m_reserved_words);
+    bench_lexer("tmd", tamarind, Semant::m_reserved_words);
+    bench_scan("asm", assembly);
+    bench_scan("tmd", tamarind);
+    bench_lookup("asm", assembly, Assembler::m_reserved_words);
+    bench_lookup("tmd", tamarind, Semant::m_reserved_words);
+
+    if (ems.has_errors()) {
+        ems.print();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tacb.hpp"
+#include "optimizer.hpp"
+#include "ControlFlowGraph.hpp"
+#include "dominator_tree.hpp"
+#include "dataflow.hpp"
+#include "ssa.hpp"
+
+/*
+ * Optimizer benchmark
+ * Replays IR dumped with `tama --tacb` and reports the time spent mapping and loading
+ * each file and running each optimizer pass over it.
+ */
+
+template <typename F>
+static double best_of(int runs, F f) {
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        if (d.count() < best) best = d.count();
+    }
+    return best;
+}
+
+//times pass over a fresh copy of the module each run, so every run sees the same input
+template <typename F>
+static double time_pass(const std::vector<TacFunction>& module, F pass) {
+    double best = 1e30;
+    for (int i = 0; i < 5; i++) {
+        std::vector<TacFunction> functions = module;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        pass(&functions);
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        if (d.count() < best) best = d.count();
+    }
+    return best;
+}
+
+static bool bench_file(const std::string& path) {
+    TacbFile tacb;
+    double open_secs = best_of(5, [&]() { tacb.open(path); });
+    if (!tacb.open(path)) {
+        printf("%s: not a valid .tacb file\n", path.c_str());
+        return false;
+    }
+
+    std::vector<TacFunction> module;
+    std::unordered_map<SymbolId, X86Frame> frames;
+    double load_secs = best_of(5, [&]() {
+        module.clear();
+        frames.clear();
+        tacb.load(&module, &frames);
+    });
+
+    printf("%s: %u functions  %u blocks  %u quads\n", path.c_str(),
+           tacb.header().m_function_count, tacb.header().m_block_count, tacb.header().m_quad_count);
+    printf("    open      %8.3f ms\n", open_secs * 1e3);
+    printf("    load      %8.3f ms\n", load_secs * 1e3);
+
+    Optimizer opt;
+    auto per_function = [](void (Optimizer::*pass)(TacFunction*), Optimizer& opt) {
+        return [pass, &opt](std::vector<TacFunction>* functions) {
+            for (TacFunction& fn: *functions) {
+                (opt.*pass)(&fn);
+            }
+        };
+    };
+
+    double dce_secs = time_pass(module, [&](std::vector<TacFunction>* functions) {
+        opt.eliminate_dead_code(functions);
+    });
+    printf("    dce       %8.3f ms\n", dce_secs * 1e3);
+    printf("    cfg       %8.3f ms\n", time_pass(module, [](std::vector<TacFunction>* functions) {
+        for (const TacFunction& fn: *functions) {
+            ControlFlowGraph cfg(fn);
+        }
+    }) * 1e3);
+    printf("    dom       %8.3f ms\n", time_pass(module, [](std::vector<TacFunction>* functions) {
+        for (const TacFunction& fn: *functions) {
+            ControlFlowGraph cfg(fn);
+            DominatorTree dom(cfg);
+            DominatorTree pdom(cfg, true);
+        }
+    }) * 1e3);
+    printf("    liveness  %8.3f ms\n", time_pass(module, [](std::vector<TacFunction>* functions) {
+        for (const TacFunction& fn: *functions) {
+            ControlFlowGraph cfg(fn);
+            Liveness live(fn, cfg);
+        }
+    }) * 1e3);
+    printf("    reaching  %8.3f ms\n", time_pass(module, [](std::vector<TacFunction>* functions) {
+        for (const TacFunction& fn: *functions) {
+            ControlFlowGraph cfg(fn);
+            ReachingDefinitions defs(fn, cfg);
+        }
+    }) * 1e3);
+    //a round trip through SSA form, running pass (if any) while in it
+    auto ssa_pass = [&frames, &opt](void (Optimizer::*pass)(SSATransformer*)) {
+        return [&frames, &opt, pass](std::vector<TacFunction>* functions) {
+            //each run works on a copy of the frames too, since leaving SSA may add slots to them
+            std::unordered_map<SymbolId, X86Frame> copies = frames;
+            for (TacFunction& fn: *functions) {
+                std::unordered_map<SymbolId, X86Frame>::iterator frame = copies.find(fn.m_name);
+                if (frame == copies.end()) continue;
+                SSATransformer ssa(&fn, &frame->second);
+                ssa.construct();
+                if (pass) (opt.*pass)(&ssa);
+                ssa.destruct();
+            }
+        };
+    };
+    printf("    ssa       %8.3f ms\n", time_pass(module, ssa_pass(nullptr)) * 1e3);
+    printf("    sccp      %8.3f ms  (with ssa)\n", time_pass(module, ssa_pass(&Optimizer::propagate_constants)) * 1e3);
+    printf("    gvn       %8.3f ms  (with ssa)\n", time_pass(module, ssa_pass(&Optimizer::eliminate_common_subexpressions)) * 1e3);
+    printf("    licm      %8.3f ms  (with ssa)\n", time_pass(module, ssa_pass(&Optimizer::hoist_loop_invariants)) * 1e3);
+    printf("    ivsr      %8.3f ms  (with ssa)\n", time_pass(module, ssa_pass(&Optimizer::reduce_induction_variables)) * 1e3);
+    printf("    collapse  %8.3f ms\n", time_pass(module, per_function(&Optimizer::collapse_cond_jumps, opt)) * 1e3);
+    printf("    merge     %8.3f ms\n", time_pass(module, per_function(&Optimizer::merge_adjacent_store_fetch, opt)) * 1e3);
+    printf("    simplify  %8.3f ms\n", time_pass(module, per_function(&Optimizer::simplify_algebraic_identities, opt)) * 1e3);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: opt_bench <file.tacb>...\n");
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        ok = bench_file(argv[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
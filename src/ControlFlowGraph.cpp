@@ -1,70 +1,118 @@
-#include "ControlFlowGraph.hpp"
+#include <algorithm>
 
+#include "ControlFlowGraph.hpp"
+#include "dominator_tree.hpp"
 
-BasicBlock* ControlFlowGraph::get_block(const std::string& name) {
-    for (BasicBlock& b: m_blocks) {
-        if (b.m_label == name) {
-            return &b;
-        }
-    }
 
-    return nullptr;
+//jumps to labels the function doesn't define are left to the assembler to report
+void ControlFlowGraph::add_edge(BlockId from, BlockId to) {
+    if (to == BLOCK_NONE) return;
+    std::vector<BlockId>& succs = m_blocks[from].m_succs;
+    if (std::find(succs.begin(), succs.end(), to) != succs.end()) return;
+    succs.push_back(to);
+    m_blocks[to].m_preds.push_back(from);
 }
 
-void ControlFlowGraph::create_basic_blocks(const std::vector<TacQuad>& quads, const std::vector<std::string>& labels) {
-    std::string block_label = "";
-    int begin_idx;
-    for (int i = 0; i < quads.size(); i++) {
-        if (block_label != "") {
-            std::string l = labels[i];
-            if (l == "") continue;
-
-            m_blocks.push_back({block_label, begin_idx, i});
-            begin_idx = i;
-            block_label = l;
-
-        } else {
-            std::string l = labels[i];
-            if (l == "") continue;
+ControlFlowGraph::ControlFlowGraph(const TacFunction& fn) {
+    for (const TacBlock& b: fn.m_blocks) {
+        m_blocks.push_back(BasicBlock(b.m_label));
+    }
 
-            begin_idx = i;
-            block_label = l;
+    for (BlockId i = 0; i < fn.m_blocks.size(); i++) {
+        const TacBlock& b = fn.m_blocks[i];
+        for (InstrId j = b.m_first; j != INSTR_NONE; j = fn.next(j)) {
+            const TacQuad* q = &fn.quad(j);
+            if (q->m_op == TacT::Goto) {
+                add_edge(i, fn.block_of(q->opd2().m_value));
+            } else if (q->m_op == TacT::CondGoto) {
+                add_edge(i, fn.block_of(q->opd1().m_value));
+                if (!q->opd2().is_none()) {
+                    add_edge(i, fn.block_of(q->opd2().m_value));
+                }
+            }
         }
 
+        if (i + 1 < fn.m_blocks.size() && fn.falls_through(i)) {
+            add_edge(i, i + 1);
+        }
     }
-
-    m_blocks.push_back({block_label, begin_idx, quads.size()});
 }
 
-void ControlFlowGraph::generate_inter_block_edges(const std::vector<TacQuad>& quads) {
-    for (int i = 0; i < m_blocks.size(); i++) {
-        BasicBlock* b = &m_blocks[i];
-        for (int j = b->m_begin; j < b->m_end; j++) {
-            const TacQuad* q = &quads[j];
-            if (q->m_op == TacT::Goto) {
-                m_edges.push_back({b->m_label, q->m_opd2});
-            } else if (q->m_op == TacT::CondGoto) {
-                m_edges.push_back({b->m_label, q->m_opd1});
-                m_edges.push_back({b->m_label, q->m_opd2});
+//blocks the entry can't reach come last, in layout order
+std::vector<BlockId> ControlFlowGraph::reverse_postorder() const {
+    std::vector<BlockId> order;
+    std::vector<bool> seen(m_blocks.size(), false);
+    std::vector<std::pair<BlockId, size_t>> stack;
+    if (!m_blocks.empty()) {
+        stack.push_back({ENTRY, 0});
+        seen[ENTRY] = true;
+    }
+    while (!stack.empty()) {
+        std::pair<BlockId, size_t>& top = stack.back();
+        if (top.second < m_blocks[top.first].m_succs.size()) {
+            BlockId next = m_blocks[top.first].m_succs[top.second++];
+            if (!seen[next]) {
+                seen[next] = true;
+                stack.push_back({next, 0});
             }
+        } else {
+            order.push_back(top.first);
+            stack.pop_back();
         }
     }
+    std::reverse(order.begin(), order.end());
+
+    for (BlockId b = 0; b < m_blocks.size(); b++) {
+        if (!seen[b]) order.push_back(b);
+    }
+    return order;
 }
 
-void ControlFlowGraph::generate_inter_procedural_edges(const std::vector<TacQuad>& quads) {
-    for (int i = 0; i < m_blocks.size(); i++) {
-        BasicBlock* b = &m_blocks[i];
-        for (int j = b->m_begin; j < b->m_end; j++) {
-            const TacQuad* q = &quads[j];
-            if (q->m_op == TacT::CallNil || q->m_op == TacT::CallResult) {
-                m_edges.push_back({b->m_label, q->m_opd2});
+//an edge is a back edge when its target dominates its source
+std::vector<Loop> ControlFlowGraph::natural_loops(const DominatorTree& dom) const {
+    std::vector<Loop> loops;
+    std::vector<BlockId> stack;
+    std::vector<size_t> in_loop(m_blocks.size(), SIZE_MAX); //the last loop each block was added to
+    for (BlockId h: dom.order()) {
+        Loop loop{h, {}, {h}};
+        for (BlockId p: m_blocks[h].m_preds) {
+            if (dom.dominates(h, p)) loop.m_latches.push_back(p);
+        }
+        if (loop.m_latches.empty()) continue;
+
+        //walk back from the latches; the header stops the walk, since it dominates all of them
+        in_loop[h] = loops.size();
+        for (BlockId l: loop.m_latches) {
+            if (in_loop[l] == loops.size()) continue;
+            in_loop[l] = loops.size();
+            stack.push_back(l);
+        }
+        while (!stack.empty()) {
+            BlockId b = stack.back();
+            stack.pop_back();
+            loop.m_blocks.push_back(b);
+            for (BlockId p: m_blocks[b].m_preds) {
+                if (in_loop[p] == loops.size() || !dom.reachable(p)) continue;
+                in_loop[p] = loops.size();
+                stack.push_back(p);
             }
         }
+        loops.push_back(std::move(loop));
     }
-}
 
-void ControlFlowGraph::generate_graph(const std::vector<TacQuad>& quads) {
-    generate_inter_block_edges(quads);
-    generate_inter_procedural_edges(quads);
+    //a loop nested in another has fewer blocks, and different headers make different loops
+    std::stable_sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+        return a.m_blocks.size() < b.m_blocks.size();
+    });
+    return loops;
+}
 
+BlockId ControlFlowGraph::preheader(const Loop& loop) const {
+    const std::vector<BlockId>& preds = m_blocks[loop.m_header].m_preds;
+    if (preds.size() != loop.m_latches.size() + 1) return BLOCK_NONE;
+    for (BlockId p: preds) {
+        if (std::find(loop.m_latches.begin(), loop.m_latches.end(), p) != loop.m_latches.end()) continue;
+        return m_blocks[p].m_succs.size() == 1 ? p : BLOCK_NONE;
+    }
+    return BLOCK_NONE;
 }
@@ -2,8 +2,12 @@
 #define CONTROL_FLOW_GRAPH_HPP
 
 #include <vector>
+#include <algorithm>
 #include "tac.hpp"
 
+/*
+ * Blocks refer to each other by BlockId, which is also their index in the function.
+ */
 class BasicBlock {
     public:
         enum class Color {
@@ -12,31 +16,48 @@ class BasicBlock {
             White
         };
     public:
-        std::string m_label;
-        int m_begin;
-        int m_end; //index of one quad after end of block
+        SymbolId m_label;
         Color m_mark = Color::Black;
-        BasicBlock(const std::string& label, int begin, int end): m_label(label), m_begin(begin), m_end(end) {}
+        std::vector<BlockId> m_succs; //blocks control can pass to: jump targets and the fall-through block
+        std::vector<BlockId> m_preds;
+        BasicBlock(SymbolId label): m_label(label) {}
 };
 
-class BlockEdge {
-    public:
-        std::string m_from;
-        std::string m_to;
-};
+class DominatorTree;
 
+/*
+ * A natural loop: the header and every block that reaches one of its back edges without passing
+ * through the header. Back edges sharing a header make up one loop.
+ */
+struct Loop {
+    BlockId m_header;
+    std::vector<BlockId> m_latches; //sources of the back edges
+    std::vector<BlockId> m_blocks; //header first
+};
 
+/*
+ * Control-flow graph of one function, entered at block 0.
+ * Calls don't leave the graph - they are edges of the CallGraph instead.
+ */
 class ControlFlowGraph {
     public:
-        void create_basic_blocks(const std::vector<TacQuad>& quads, const std::vector<std::string>& labels);
-        void generate_graph(const std::vector<TacQuad>& quads);
-        BasicBlock* get_block(const std::string& name);
+        static constexpr BlockId ENTRY = 0;
+    public:
+        explicit ControlFlowGraph(const TacFunction& fn);
+        std::vector<BlockId> reverse_postorder() const;
+        //the loops of the blocks dom covers, each one before any loop enclosing it
+        std::vector<Loop> natural_loops(const DominatorTree& dom) const;
+        //the one block that enters loop from outside, if it leads nowhere else; otherwise BLOCK_NONE
+        BlockId preheader(const Loop& loop) const;
+        //position of pred among block's predecessors, which is also the index of its phi arguments
+        size_t pred_index(BlockId block, BlockId pred) const {
+            const std::vector<BlockId>& preds = m_blocks[block].m_preds;
+            return std::find(preds.begin(), preds.end(), pred) - preds.begin();
+        }
     private:
-        void generate_inter_block_edges(const std::vector<TacQuad>& quads);
-        void generate_inter_procedural_edges(const std::vector<TacQuad>& quads);
+        void add_edge(BlockId from, BlockId to);
     public:
         std::vector<BasicBlock> m_blocks;
-        std::vector<BlockEdge> m_edges;
 };
 
 
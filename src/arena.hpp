@@ -0,0 +1,52 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/*
+ * Bump allocator for memory that lives as long as its owner.
+ * Nothing is freed individually - every block is released when the arena is destroyed,
+ * so only raw bytes and trivially destructible data belong here.
+ */
+class Arena {
+    public:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    private:
+        std::vector<char*> m_blocks;
+        char* m_ptr = nullptr;
+        char* m_end = nullptr;
+    public:
+        Arena() {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena() {
+            for (char* b: m_blocks) {
+                free(b);
+            }
+        }
+
+        void* alloc(size_t size, size_t align) {
+            uintptr_t p = ((uintptr_t)m_ptr + align - 1) & ~(uintptr_t)(align - 1);
+            if (m_ptr == nullptr || p + size > (uintptr_t)m_end) {
+                grow(size + align);
+                p = ((uintptr_t)m_ptr + align - 1) & ~(uintptr_t)(align - 1);
+            }
+            m_ptr = (char*)(p + size);
+            return (void*)p;
+        }
+    private:
+        void grow(size_t min_size) {
+            size_t size = min_size > BLOCK_SIZE ? min_size : BLOCK_SIZE;
+            char* b = (char*)malloc(size);
+            if (b == nullptr) throw std::bad_alloc();
+            m_blocks.push_back(b);
+            m_ptr = b;
+            m_end = b + size;
+        }
+};
+
+#endif //ARENA_HPP
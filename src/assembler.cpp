@@ -1,6 +1,5 @@
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <cstring>
 #include <utility>
 
@@ -179,9 +178,9 @@ void Assembler::append_rel_section(int sh_rel_offset, int sh_text_offset, int sh
 void Assembler::generate_obj(const std::string& input_file, const std::string& output_file) {
     read(input_file);
     lex();
-    if (ems.has_errors()) return;
+    if (m_ems.has_errors()) return;
     parse();
-    if (ems.has_errors()) return;
+    if (m_ems.has_errors()) return;
 
     Elf32ElfHeader eh;
     eh.m_shstrndx = 2;
@@ -229,7 +228,7 @@ void Assembler::generate_obj(const std::string& input_file, const std::string& o
         append_rel_section(sh_rel_offset, sh_text_offset, sh_symtab_offset, sh_strtab_offset);
     }
 
-    if (ems.has_errors()) return;
+    if (m_ems.has_errors()) return;
     write(output_file);
 
 
@@ -243,27 +242,22 @@ int Assembler::append_section_header(Elf32SectionHeader h) {
 
 
 void Assembler::read(const std::string& input_file) {
-    std::ifstream f(input_file);
-    std::stringstream buffer;
-    buffer << f.rdbuf();
-    m_assembly = buffer.str();
+    if (!m_source.open(input_file)) {
+        m_ems.add_error(0, "Error: Could not open '%s'.", input_file.c_str());
+    }
 }
 
+//tokens are lexed on demand while parsing, so this only sets up the token stream
 void Assembler::lex() {
-    m_tokens = m_lexer.lex(m_assembly, m_reserved_words);
- 
-    /* 
-    for (struct Token t: m_tokens) {
-        printf("%.*s\n", t.len, t.start);
-    }*/
+    m_tokens.init(m_source, m_reserved_words, m_ems);
 }
 
-Assembler::Node *Assembler::parse_unit() {
+NodeId Assembler::parse_unit() {
     struct Token next = next_token();
     switch (next.type) {
         case T_INT:
         case T_HEX:
-            return new NodeImm(next);
+            return add_node(NodeKind::Imm, next);
         case T_EAX:
         case T_ECX:
         case T_EDX:
@@ -272,7 +266,7 @@ Assembler::Node *Assembler::parse_unit() {
         case T_EBP:
         case T_ESI:
         case T_EDI:
-            return new NodeReg32(next);
+            return add_node(NodeKind::Reg32, next);
         case T_AL:
         case T_CL:
         case T_DL:
@@ -281,95 +275,110 @@ Assembler::Node *Assembler::parse_unit() {
         case T_CH:
         case T_DH:
         case T_BH:
-            return new NodeReg8(next);
+            return add_node(NodeKind::Reg8, next);
         case T_IDENTIFIER:
-            return new NodeLabelRef(next);
+            return add_node(NodeKind::LabelRef, next);
         case T_L_BRACKET: {
-            Node* reg = parse_unit();
-            if (!dynamic_cast<NodeReg32*>(reg)) {
-                ems.add_error(next.line, "Parse Error: Memory access requires register before displacement");
+            NodeId reg = parse_unit();
+            if (!is_kind(reg, NodeKind::Reg32)) {
+                m_ems.add_error(m_source.line(next), "Parse Error: Memory access requires register before displacement");
             }
             if (peek_one().type == T_R_BRACKET) {
                 consume_token(T_R_BRACKET);
-                return new NodeMem(reg, NULL);
+                return add_node(NodeKind::Mem, m_nodes[reg].m_t, reg);
             } else if (peek_one().type == T_PLUS) {
                 next_token(); //Skip '+'
-                Node* displacement = parse_operand();
+                NodeId displacement = parse_operand();
                 consume_token(T_R_BRACKET);
-                return new NodeMem(reg, displacement);
+                return add_node(NodeKind::Mem, m_nodes[reg].m_t, reg, displacement);
             } else if (peek_one().type == T_MINUS) {
-                Node *displacement = parse_operand();
+                NodeId displacement = parse_operand();
                 consume_token(T_R_BRACKET);
-                return new NodeMem(reg, displacement);
+                return add_node(NodeKind::Mem, m_nodes[reg].m_t, reg, displacement);
             }
-            ems.add_error(next.line, "Parse Error: Unrecognized token in memory access!");
-            return NULL;
+            m_ems.add_error(m_source.line(next), "Parse Error: Unrecognized token in memory access!");
+            return NODE_NONE;
         }
         default:
-            ems.add_error(next.line, "Parse Error: Unrecognized token!");
+            m_ems.add_error(m_source.line(next), "Parse Error: Unrecognized token!");
     }
-    return NULL;
+    return NODE_NONE;
 }
 
-Assembler::Node *Assembler::parse_unary() {
+NodeId Assembler::parse_unary() {
     if (peek_one().type == T_MINUS) {
         struct Token op = next_token();
-        return new NodeUnary(op, parse_unary());
+        return add_node(NodeKind::Unary, op, NODE_NONE, parse_unary());
     } else {
         return parse_unit();
     }
 }
 
-Assembler::Node *Assembler::parse_factor() {
-    Node *left = parse_unary();
+NodeId Assembler::parse_factor() {
+    NodeId left = parse_unary();
     while (peek_one().type == T_STAR || peek_one().type == T_SLASH) {
         struct Token op = next_token();
-        left = new NodeBinary(op, left, parse_unary());
+        left = add_node(NodeKind::Binary, op, left, parse_unary());
     }
     return left;
 }
 
-Assembler::Node *Assembler::parse_term() {
-    Node *left = parse_factor();
+NodeId Assembler::parse_term() {
+    NodeId left = parse_factor();
     while (peek_one().type == T_PLUS || peek_one().type == T_MINUS) {
         struct Token op = next_token();
-        left = new NodeBinary(op, left, parse_factor());
+        left = add_node(NodeKind::Binary, op, left, parse_factor());
     }
     return left;
 }
 
-Assembler::Node *Assembler::parse_operand() {
-    Node *operand = parse_term();
+NodeId Assembler::parse_operand() {
+    NodeId operand = parse_term();
     return operand;
 }
 
-Assembler::Node *Assembler::parse_stmt() {
+NodeId Assembler::parse_stmt() {
     struct Token next = peek_one();
     //if identifer followed by a colon, then it's a label
     if (next.type == T_IDENTIFIER && peek_two().type == T_COLON) {
         struct Token id = next_token();
         consume_token(T_COLON);
-        return new NodeLabelDef(id);
+        return add_node(NodeKind::LabelDef, id);
     } else {
         struct Token op =  next_token();
-        struct Node *left = NULL;
-        struct Node *right = NULL;
+        NodeId left = NODE_NONE;
+        NodeId right = NODE_NONE;
         switch (op.type) {
             //two operands
             case T_MOV:
             case T_ADD:
             case T_SUB:
-            case T_IMUL:
             case T_XOR:
             case T_CMP:
             case T_TEST:
             case T_MOVZX:
             case T_AND:
             case T_OR:
+            case T_LEA:
+            case T_SHL:
+            case T_SAR:
+            case T_SHR:
                 left = parse_operand();
                 consume_token(T_COMMA);
                 right = parse_operand();
                 break;
+            //one, two or three operands
+            case T_IMUL:
+                left = parse_operand();
+                if (peek_one().type == T_COMMA) {
+                    consume_token(T_COMMA);
+                    right = parse_operand();
+                }
+                if (peek_one().type == T_COMMA) {
+                    struct Token comma = consume_token(T_COMMA);
+                    right = add_node(NodeKind::Pair, comma, right, parse_operand());
+                }
+                break;
             //single operand
             case T_POP:
             case T_PUSH:
@@ -397,65 +406,656 @@ Assembler::Node *Assembler::parse_stmt() {
             case T_RET:
                 break;
             default:
-                ems.add_error(next.line, "Parse Error: Invalid token type!");
+                m_ems.add_error(m_source.line(next), "Parse Error: Invalid token type!");
         }
-        return new NodeOp(op, left, right);
+        return add_node(NodeKind::Op, op, left, right);
     }
 }
 
 void Assembler::parse() {
-    
     while (peek_one().type != T_EOF) {
-        m_nodes.push_back(parse_stmt());
+        m_stmts.push_back(parse_stmt());
     }
+}
 
-    
-    for (Node* n: m_nodes) {
-    //    std::cout << "instruction: " << n->to_string() << '\n';
-    }
+NodeId Assembler::add_node(NodeKind kind, struct Token t, NodeId left, NodeId right) {
+    m_nodes.push_back({t, kind, left, right});
+    return m_nodes.size() - 1;
 }
 
 struct Token Assembler::peek_one() {
-    uint32_t next = m_current;
-    if (next >= m_tokens.size())
-        next = m_tokens.size() - 1;
-    return m_tokens[next];
+    return m_tokens.peek_one();
 }
 
 struct Token Assembler::peek_two() {
-    uint32_t next = m_current + 1;
-    if (next >= m_tokens.size())
-        next = m_tokens.size() - 1;
-    return m_tokens[next];
+    return m_tokens.peek_two();
 }
 
 struct Token Assembler::next_token() {
-    uint32_t next = m_current;
-    if (next >= m_tokens.size())
-        next = m_tokens.size() - 1;
-    struct Token ret = m_tokens[next];
-    m_current++;
-    return ret;
+    return m_tokens.next_token();
 }
 
 struct Token Assembler::consume_token(enum TokenType tt) {
-    struct Token t = next_token();
-    if (t.type != tt) {
-        ems.add_error(t.line, "Unexpected token!");
-    }
-    return t;
+    return m_tokens.consume_token(tt);
 }
 
 bool Assembler::end_of_tokens() {
-    return m_current == m_tokens.size();
+    return m_tokens.end_of_tokens();
 }
 
 /*Translate assembly to machine code*/
 
 
+uint8_t Assembler::bit_pattern(const Node& reg) {
+    switch(reg.m_t.type) {
+        case T_EAX: case T_AL: return 0;
+        case T_ECX: case T_CL: return 1;
+        case T_EDX: case T_DL: return 2;
+        case T_EBX: case T_BL: return 3;
+        case T_ESP: case T_AH: return 4;
+        case T_EBP: case T_CH: return 5;
+        case T_ESI: case T_DH: return 6;
+        case T_EDI: case T_BH: return 7;
+        default:
+            assert(false && "bit_pattern called on a non-register node");
+            return 0;
+    }
+}
+
+int32_t Assembler::eval(NodeId id) {
+    const Node& n = m_nodes[id];
+    switch (n.m_kind) {
+        case NodeKind::Imm: {
+            //parse within the token since the source buffer isn't null-terminated
+            const char* p = m_source.start(n.m_t);
+            uint32_t ret = 0;
+            if (n.m_t.type == T_INT) {
+                for (int i = 0; i < n.m_t.len; i++) {
+                    ret = ret * 10 + (p[i] - '0');
+                }
+            } else if (n.m_t.type == T_HEX) {
+                for (int i = 2; i < n.m_t.len; i++) {
+                    char c = p[i];
+                    uint32_t digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+                    ret = ret * 16 + digit;
+                }
+            }
+            return (int32_t)ret;
+        }
+        case NodeKind::Unary: {
+            //assert that right is Imm, Unary or Binary
+            if (n.m_t.type == T_MINUS) {
+                return -1 * eval(n.m_right);
+            }
+            m_ems.add_error(m_source.line(n.m_t), "Assembler Error: Only '-' are recognized as unary operators");
+            return 0;
+        }
+        case NodeKind::Binary: {
+            //assert that left/right are Imm, Unary or Binary
+            uint32_t left = eval(n.m_left);
+            uint32_t right = eval(n.m_right);
+            switch(n.m_t.type) {
+                case T_PLUS:    return left + right;
+                case T_MINUS:   return left - right;
+                case T_STAR:    return left * right;
+                case T_SLASH:   return left / right;
+                default:
+                    m_ems.add_error(m_source.line(n.m_t), "Assembler Error: binary operator must be *+-/"); 
+                    return 0;
+            }
+        }
+        default:
+            assert(false && "only Imm, Unary and Binary nodes can be evaluated");
+            return 0;
+    }
+}
+
+void Assembler::assemble(NodeId id) {
+    const Node& n = m_nodes[id];
+    switch (n.m_kind) {
+        case NodeKind::Op:
+            assemble_op(n);
+            break;
+        case NodeKind::Imm:
+        case NodeKind::Unary:
+        case NodeKind::Binary: {
+            int32_t result = eval(id);
+            m_buf.insert(m_buf.end(), (uint8_t*)&result, (uint8_t*)&result + sizeof(int32_t));
+            break;
+        }
+        case NodeKind::LabelRef: {
+            std::string s = m_source.str(n.m_t);
+            std::unordered_map<std::string, Label>::iterator it = m_labels.find(s);
+            if (it == m_labels.end()) {
+                m_labels.insert({s, Label(n.m_t, 0, false)});
+                it = m_labels.find(s);
+            }
+            it->second.m_rjmp_addr.push_back(m_buf.size());
+
+            uint32_t addr = m_buf.size() + 4;
+            m_buf.insert(m_buf.end(), (uint8_t*)&addr, (uint8_t*)&addr + sizeof(uint32_t));
+            break;
+        }
+        case NodeKind::LabelDef: {
+            std::string s = m_source.str(n.m_t);
+            std::unordered_map<std::string, Label>::iterator it = m_labels.find(s);
+            if (it != m_labels.end()) {
+                if (it->second.m_defined) {
+                    m_ems.add_error(m_source.line(n.m_t), "Assembler Error: Labels cannot be defined more than once.");
+                } else {
+                    it->second.m_t = n.m_t;
+                    it->second.m_addr = m_buf.size();
+                    it->second.m_defined = true;
+                }
+            } else {
+                m_labels.insert({s, Label(n.m_t, m_buf.size(), true)});
+            }
+            break;
+        }
+        case NodeKind::Reg32:
+        case NodeKind::Reg8:
+        case NodeKind::Mem:
+        case NodeKind::Pair:
+            //operands are encoded by the instruction that uses them
+            break;
+    }
+}
+
+//the ModRM byte and displacement of [ebp + disp]: 8 bits when it fits, 32 otherwise
+void Assembler::assemble_ebp_mem(const Node& mem, uint8_t reg_field) {
+    const Node& base = m_nodes[mem.m_left];
+    if (base.m_t.type != T_EBP) {
+        printf("Dereferencing only supported with ebp for now!\n");
+    }
+
+    int32_t dis = is_expr(mem.m_right) ? eval(mem.m_right) : 0;
+    if (dis >= -128 && dis <= 127) {
+        m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_01] | reg_field << 3 | bit_pattern(base));
+        m_buf.push_back((uint8_t)dis);
+    } else {
+        m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_10] | reg_field << 3 | bit_pattern(base));
+        m_buf.insert(m_buf.end(), (uint8_t*)&dis, (uint8_t*)&dis + sizeof(int32_t));
+    }
+}
+
+//shifts a register by a constant count; ext is the opcode extension picking the kind of shift
+void Assembler::assemble_shift(const Node& n, uint8_t ext) {
+    if (is_kind(n.m_left, NodeKind::Reg32) && is_expr(n.m_right)) {
+        m_buf.push_back(0xc1);
+        m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | ext << 3 | bit_pattern(m_nodes[n.m_left]));
+        m_buf.push_back((uint8_t)eval(n.m_right));
+    } else {
+        m_ems.add_error(m_source.line(n.m_t), "Assembler Error: shifts only work with a register and a constant count");
+    }
+}
+
+void Assembler::assemble_op(const Node& n) {
+    switch(n.m_t.type) {
+        case T_ADD: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                m_buf.push_back(0x01);
+                const Node& dst = m_nodes[n.m_left];
+                const Node& src = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(src) << 3 | bit_pattern(dst));
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_expr(n.m_right)) {
+                const Node& reg = m_nodes[n.m_left];
+                if (reg.m_t.type == T_EAX) {
+                    m_buf.push_back(0x05);
+                } else {
+                    m_buf.push_back(0x81);
+                    m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x00 << 3 | bit_pattern(reg));
+                }
+                assemble(n.m_right);
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: add doesn't work with those operand types");
+            }
+            break;
+        }
+        case T_AND: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                //21 /r - AND r/m32, r32
+                m_buf.push_back(0x21);
+
+                const Node& mem = m_nodes[n.m_left];
+                const Node& reg = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(mem));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: and doesn't work with those operand types");
+            }
+            break;
+        }
+        case T_CALL: {
+            if (is_kind(n.m_left, NodeKind::LabelRef)) {
+                m_buf.push_back(0xe8);
+                assemble(n.m_left);
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: call only works with labels for now");
+            }
+            break;
+        }
+        case T_CDQ: {
+            //99 CDQ - EDX:EAX := sign-extend of EAX
+            m_buf.push_back(0x99);
+            break;
+        }
+        case T_CMP: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_expr(n.m_right)) {
+                //3d id <----cmp    eax, imm32
+                //81 /7 id <----- cmp   r/m32, imm32
+                const Node& reg = m_nodes[n.m_left];
+                if (reg.m_t.type == T_EAX) {
+                    m_buf.push_back(0x3d);
+                    assemble(n.m_right);
+                } else {
+                    m_buf.push_back(0x81);
+                    m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x07 << 3 | bit_pattern(reg));
+                    assemble(n.m_right);
+                }
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                //39 /r - CMP r/32, r32
+                m_buf.push_back(0x39);
+
+                const Node& mem = m_nodes[n.m_left];
+                const Node& reg = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(mem));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: cmp does not work with those operands");
+            }
+            break;
+        }
+        case T_DEC: {
+            if (is_kind(n.m_left, NodeKind::Reg32)) {
+                //ff /1 - DEC r/m32
+                m_buf.push_back(0xff);
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x01 << 3 | bit_pattern(reg));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: dec only works with registers");
+            }
+            break;
+        }
+        case T_DIV: {
+            //F7 /6 - DIV EDX:EAX by r/m32 with EAX := quotient and EDX := remainder
+            if (is_kind(n.m_left, NodeKind::Reg32)) {
+                m_buf.push_back(0xf7);
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x06 << 3 | bit_pattern(reg));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: div only works with register");
+            }
+            break;
+        }
+        case T_IDIV: {
+            //F7 /7 - IDIV EDX:EAX by rm/32 with EAX := quotient and EDX := remainder
+            if (is_kind(n.m_left, NodeKind::Reg32)) {
+                m_buf.push_back(0xf7);
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x07 << 3 | bit_pattern(reg));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: div only works with register");
+            }
+            break;
+        }
+        case T_IMUL: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && n.m_right == NODE_NONE) {
+                //F7 /5 - IMUL r/m32 with EDX:EAX := EAX * r/m32
+                m_buf.push_back(0xf7);
+                const Node& r_m = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x05 << 3 | bit_pattern(r_m));
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                //0F AF /r - IMUL r32, r/m32
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0xaf);
+                const Node& reg = m_nodes[n.m_left];
+                const Node& r_m = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(r_m));
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Pair) &&
+                       is_expr(m_nodes[n.m_right].m_right)) {
+                //6B /r ib - IMUL r32, r/m32, imm8
+                //69 /r id - IMUL r32, r/m32, imm32
+                const Node& reg = m_nodes[n.m_left];
+                const Node& pair = m_nodes[n.m_right];
+                int32_t imm = eval(pair.m_right);
+                bool short_imm = imm >= -128 && imm <= 127;
+                m_buf.push_back(short_imm ? 0x6b : 0x69);
+                if (is_kind(pair.m_left, NodeKind::Reg32)) {
+                    m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(m_nodes[pair.m_left]));
+                } else if (is_kind(pair.m_left, NodeKind::Mem)) {
+                    assemble_ebp_mem(m_nodes[pair.m_left], bit_pattern(reg));
+                } else {
+                    m_ems.add_error(m_source.line(n.m_t), "Assembler Error: imul does not work with those operands.");
+                    break;
+                }
+                if (short_imm) {
+                    m_buf.push_back((uint8_t)imm);
+                } else {
+                    assemble(pair.m_right);
+                }
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: imul does not work with those operands.");
+            }
+            break;
+        }
+        case T_INC: {
+            if (is_kind(n.m_left, NodeKind::Reg32)) {
+                //ff /0 - INC r/m32
+                m_buf.push_back(0xff);
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: inc only works with register operands");
+            }
+            break;
+        }
+        case T_INTR: {
+            if (!is_expr(n.m_left)) {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: int operator must be followed by imm32.");
+            } else {
+                m_buf.push_back(0xcd);
+                m_buf.push_back((uint8_t)(eval(n.m_left))); //int instruction is followed by a single byte
+            }
+            break;
+        }
+        case T_JE: {
+            //0f 84 cd
+            m_buf.push_back(0x0f);
+            m_buf.push_back(0x84);
+            assemble(n.m_left);
+            break;
+        }
+        case T_JG: {
+            if (is_kind(n.m_left, NodeKind::LabelRef)) {
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x8f);
+                assemble(n.m_left);
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: jg only works with labels for now");
+            }
+            break;
+        }
+        case T_JMP: {
+            if (is_kind(n.m_left, NodeKind::LabelRef)) {
+                m_buf.push_back(0xe9);
+                assemble(n.m_left);
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: jmp only works with labels for now");
+            }
+            break;
+        }
+        case T_JNZ: {
+            if (is_kind(n.m_left, NodeKind::LabelRef)) {
+                //0F 85 cd
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x85);
+                assemble(n.m_left);
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: jnz only works with labels for now");
+            }
+            break;
+        }
+        case T_LEA: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Mem)) {
+                //8D /r - LEA r32, m
+                m_buf.push_back(0x8d);
+                const Node& reg = m_nodes[n.m_left];
+                const Node& mem = m_nodes[n.m_right];
+                const Node& base = m_nodes[mem.m_left];
+                const Node* index = is_kind(mem.m_right, NodeKind::Binary) && m_nodes[mem.m_right].m_t.type == T_STAR ?
+                                    &m_nodes[mem.m_right] : nullptr;
+                if (index && is_kind(index->m_left, NodeKind::Reg32) && is_expr(index->m_right)) {
+                    //[00<reg>100][<scale><index><base>] - base + index * scale, base can't be ebp in this form
+                    const Node& index_reg = m_nodes[index->m_left];
+                    int32_t scale = eval(index->m_right);
+                    uint8_t ss = scale == 1 ? 0 : scale == 2 ? 1 : scale == 4 ? 2 : 3;
+                    if ((scale != 1 && scale != 2 && scale != 4 && scale != 8) || base.m_t.type == T_EBP || index_reg.m_t.type == T_ESP) {
+                        m_ems.add_error(m_source.line(n.m_t), "Assembler Error: lea index must be scaled by 1, 2, 4 or 8, not on ebp or esp");
+                    }
+                    m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_00] | bit_pattern(reg) << 3 | 0x04);
+                    m_buf.push_back(ss << 6 | bit_pattern(index_reg) << 3 | bit_pattern(base));
+                } else {
+                    assemble_ebp_mem(mem, bit_pattern(reg));
+                }
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: lea needs a register and a memory operand");
+            }
+            break;
+        }
+        case T_MOV: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_expr(n.m_right)) {
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(0xb8 + reg.m_t.type);
+                assemble(n.m_right);
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                m_buf.push_back(0x89);
+                const Node& dst = m_nodes[n.m_left];
+                const Node& src = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(src) << 3 | bit_pattern(dst));
+            } else if (is_kind(n.m_left, NodeKind::Mem) && is_kind(n.m_right, NodeKind::Reg32)) {
+                //[0x89][<mod><reg>101][displacement] register to ebp memory with displacement
+                m_buf.push_back(0x89);
+                assemble_ebp_mem(m_nodes[n.m_left], bit_pattern(m_nodes[n.m_right]));
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Mem)) {
+                //[0x8b][<mod><reg>101][displacement] ebp memory with displacement to register
+                m_buf.push_back(0x8b);
+                assemble_ebp_mem(m_nodes[n.m_right], bit_pattern(m_nodes[n.m_left]));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: mov with those operands not supported");
+            }
+            break;
+        }
+        case T_MOVZX: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg8)) {
+                //0f b6 /r - MOVZX r32, r/m8 
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0xb6);
+                
+                const Node& reg = m_nodes[n.m_left];
+                const Node& mem = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(mem));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: movzx with those operands not supported");
+            }
+            break;
+        }
+        case T_NEG: {
+            if (is_kind(n.m_left, NodeKind::Reg32)) {
+                //F7 /3 - NEG r/m32
+                m_buf.push_back(0xf7);
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x03 << 3 | bit_pattern(reg));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: neg only accepts registers as operands");
+            }
+            break;
+        }
+        case T_OR: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                //09 /r - OR r/m32, r32
+                m_buf.push_back(0x09);
+
+                const Node& mem = m_nodes[n.m_left];
+                const Node& reg = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(mem));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: and doesn't work with those operand types");
+            }
+            break;
+        }
+        case T_PUSH: {
+            if (is_expr(n.m_left)) {
+                //68 id
+                m_buf.push_back(0x68);
+                assemble(n.m_left);
+            } else if (is_kind(n.m_left, NodeKind::Reg32)) {
+                //ff /6
+                m_buf.push_back(0xff);
+                const Node& reg = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x06 << 3 | bit_pattern(reg));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: push with those operands not supported");
+            }
+            break;
+        }
+        case T_POP: {
+            //58 + rd - pop stack into r32
+            const Node& reg = m_nodes[n.m_left];
+            m_buf.push_back(0x58 + reg.m_t.type);
+            break;
+        }
+        case T_RET: {
+            m_buf.push_back(0xc3);
+            break;
+        }
+        case T_SAR: {
+            //C1 /7 ib - SAR r/m32, imm8
+            assemble_shift(n, 0x07);
+            break;
+        }
+        case T_SETL: {
+            if (is_kind(n.m_left, NodeKind::Reg8)) {
+                //0f 9c 
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x9c);
+                const Node& reg8 = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg8));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: setl with those operands not supported");
+            }
+            break;
+        }
+        case T_SETG: {
+            if (is_kind(n.m_left, NodeKind::Reg8)) {
+                //0f 9f
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x9f);
+                const Node& reg8 = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg8));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: setg with those operands not supported");
+            }
+            break;
+        }
+        case T_SETLE: {
+            if (is_kind(n.m_left, NodeKind::Reg8)) {
+                //0f 9e 
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x9e);
+                const Node& reg8 = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg8));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: setle with those operands not supported");
+            }
+            break;
+        }
+        case T_SETGE: {
+            if (is_kind(n.m_left, NodeKind::Reg8)) {
+                //0f 9d
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x9d);
+                const Node& reg8 = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg8));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: setge with those operands not supported");
+            }
+            break;
+        }
+        case T_SETE: {
+            if (is_kind(n.m_left, NodeKind::Reg8)) {
+                //0f 94
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x94);
+                const Node& reg8 = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg8));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: sete with those operands not supported");
+            }
+            break;
+        }
+        case T_SETNE: {
+            if (is_kind(n.m_left, NodeKind::Reg8)) {
+                //0f 95
+                m_buf.push_back(0x0f);
+                m_buf.push_back(0x95);
+                const Node& reg8 = m_nodes[n.m_left];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg8));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: setne with those operands not supported");
+            }
+            break;
+        }
+        case T_SHL: {
+            //C1 /4 ib - SHL r/m32, imm8
+            assemble_shift(n, 0x04);
+            break;
+        }
+        case T_SHR: {
+            //C1 /5 ib - SHR r/m32, imm8
+            assemble_shift(n, 0x05);
+            break;
+        }
+        case T_SUB: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                //29 /r - SUB r/m32, r32
+                const Node& r_m = m_nodes[n.m_left];
+                const Node& reg = m_nodes[n.m_right];
+                m_buf.push_back(0x29); 
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(reg) << 3 | bit_pattern(r_m));
+            } else if (is_kind(n.m_left, NodeKind::Reg32) && is_expr(n.m_right)) {
+                const Node& reg = m_nodes[n.m_left];
+                if (reg.m_t.type == T_EAX) {
+                    //2D id - SUB EAX, imm32
+                    m_buf.push_back(0x2d);
+                    assemble(n.m_right);
+                } else {
+                    //81 /5 id - SUB r/m32, imm32
+                    m_buf.push_back(0x81);
+                    m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x5 << 3 | bit_pattern(reg));
+                    assemble(n.m_right);
+                }
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: SUB does not work with those operands.");
+            }
+            break;
+        }
+        case T_TEST: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_expr(n.m_right)) {
+                const Node& reg = m_nodes[n.m_left];
+                if (reg.m_t.type == T_EAX) {
+                    //A9 id - TEST EAX, imm32
+                    m_buf.push_back(0xa9);
+                    assemble(n.m_right);
+                } else {
+                    //F7 /0 id - TEST r/m32, imm32
+                    m_buf.push_back(0xf7);
+                    m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | 0x0 << 3 | bit_pattern(reg));
+                    assemble(n.m_right);
+                }
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: test operator only works with [reg], [imm] for now");
+            }
+            break;
+        }
+        case T_XOR: {
+            if (is_kind(n.m_left, NodeKind::Reg32) && is_kind(n.m_right, NodeKind::Reg32)) {
+                m_buf.push_back(0x33);
+
+                const Node& dst = m_nodes[n.m_left];
+                const Node& src = m_nodes[n.m_right];
+                m_buf.push_back(mod_tbl[(uint8_t)OpMod::MOD_REG] | bit_pattern(dst) << 3 | bit_pattern(src));
+            } else {
+                m_ems.add_error(m_source.line(n.m_t), "Assembler Error: xor only works with register operands for now.");
+            }
+            break;
+        }
+        default:
+            m_ems.add_error(m_source.line(n.m_t), "Assembler Error: operator not currently supported.");
+            break;
+    }
+}
+
 void Assembler::append_program() {
-    for (Node *n: m_nodes) {
-        n->assemble(*this);
+    for (NodeId id: m_stmts) {
+        assemble(id);
     }
 
     patch_rel_jumps();
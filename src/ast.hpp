@@ -1,18 +1,100 @@
 #ifndef AST_HPP
 #define AST_HPP
 
-#include <string>
+#include <cstdint>
 #include <vector>
 #include "token.hpp"
-#include "tac.hpp"
-#include "type.hpp"
+#include "interner.hpp"
 
-class Semant;
+typedef uint32_t AstId;
+static constexpr AstId AST_NONE = UINT32_MAX;
 
-class Ast {
+enum class AstKind: uint16_t {
+    Binary,
+    Unary,
+    Literal,
+    Print,
+    ExprStmt,
+    Param,
+    FunDef,
+    DeclSym,
+    GetSym,
+    SetSym,
+    Block,
+    If,
+    While,
+    Call,
+    Return,
+    Import
+};
+
+/*
+ * A single node of the flat syntax tree. Children are indices into the same AstTree,
+ * and variable-length child lists are (first, count) ranges in AstTree::m_lists.
+ *
+ * Binary:   m_t operator, m_a left, m_b right
+ * Unary:    m_t operator, m_a right
+ * Literal:  m_t lexeme
+ * Print:    m_t 'print', m_a argument
+ * ExprStmt: m_t first token of the expression, m_a expression
+ * Param:    m_t symbol, m_aux data type
+ * FunDef:   m_t symbol, m_aux return type, m_a/m_b parameter list, m_c body
+ * DeclSym:  m_t symbol, m_aux data type, m_a value
+ * GetSym:   m_t symbol
+ * SetSym:   m_t symbol, m_a value
+ * Block:    m_t '{', m_a/m_b statement list
+ * If:       m_t 'if', m_a condition, m_b then block, m_c else block (AST_NONE if absent)
+ * While:    m_t 'while', m_a condition, m_b body
+ * Call:     m_t symbol, m_a/m_b argument list
+ * Return:   m_t 'return', m_a expression
+ * Import:   m_t module symbol
+ *
+ * Nodes that name a symbol (Param, FunDef, DeclSym, GetSym, SetSym, Call) carry its interned id in m_sym.
+ */
+struct AstNode {
+    struct Token m_t;
+    AstKind m_kind;
+    uint16_t m_aux;
+    uint32_t m_a;
+    uint32_t m_b;
+    uint32_t m_c;
+    SymbolId m_sym;
+};
+
+static_assert(sizeof(AstNode) == 28, "AstNode should stay compact");
+
+class AstTree {
     public:
-        virtual std::string to_string() = 0;
-        virtual EmitTacResult emit_ir(Semant& s) = 0;
+        std::vector<AstNode> m_nodes;
+        std::vector<AstId> m_lists;
+    public:
+        AstId add(AstKind kind, struct Token t, uint32_t a = AST_NONE, uint32_t b = AST_NONE, uint32_t c = AST_NONE,
+                  uint16_t aux = 0, SymbolId sym = Interner::EMPTY) {
+            m_nodes.push_back({t, kind, aux, a, b, c, sym});
+            return m_nodes.size() - 1;
+        }
+
+        //copies a finished child list into m_lists and returns the index of its first element
+        uint32_t add_list(const std::vector<AstId>& ids) {
+            uint32_t first = m_lists.size();
+            m_lists.insert(m_lists.end(), ids.begin(), ids.end());
+            return first;
+        }
+
+        const AstNode& operator[](AstId id) const {
+            return m_nodes[id];
+        }
+
+        const AstId* list(uint32_t first) const {
+            return m_lists.data() + first;
+        }
+
+        void clear() {
+            m_nodes.clear();
+            m_nodes.shrink_to_fit();
+            m_lists.clear();
+            m_lists.shrink_to_fit();
+        }
 };
 
 
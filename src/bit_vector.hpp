@@ -0,0 +1,75 @@
+#ifndef BIT_VECTOR_HPP
+#define BIT_VECTOR_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Fixed-size dense set of small integers, stored 64 to a word.
+ * Set operations report whether they changed anything, which is what dataflow solvers iterate on.
+ */
+class BitVector {
+    private:
+        std::vector<uint64_t> m_words;
+        size_t m_size = 0;
+    public:
+        BitVector() {}
+        explicit BitVector(size_t size, bool value = false): m_words((size + 63) / 64, value ? ~0ull : 0ull), m_size(size) {
+            clear_padding();
+        }
+        size_t size() const { return m_size; }
+        bool test(size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+        void set(size_t i) { m_words[i / 64] |= 1ull << (i % 64); }
+        void reset(size_t i) { m_words[i / 64] &= ~(1ull << (i % 64)); }
+        void set_all() {
+            for (uint64_t& w: m_words) w = ~0ull;
+            clear_padding();
+        }
+        void reset_all() {
+            for (uint64_t& w: m_words) w = 0;
+        }
+        bool union_with(const BitVector& other) {
+            uint64_t changed = 0;
+            for (size_t i = 0; i < m_words.size(); i++) {
+                uint64_t w = m_words[i] | other.m_words[i];
+                changed |= w ^ m_words[i];
+                m_words[i] = w;
+            }
+            return changed != 0;
+        }
+        bool intersect_with(const BitVector& other) {
+            uint64_t changed = 0;
+            for (size_t i = 0; i < m_words.size(); i++) {
+                uint64_t w = m_words[i] & other.m_words[i];
+                changed |= w ^ m_words[i];
+                m_words[i] = w;
+            }
+            return changed != 0;
+        }
+        void subtract(const BitVector& other) {
+            for (size_t i = 0; i < m_words.size(); i++) {
+                m_words[i] &= ~other.m_words[i];
+            }
+        }
+        bool operator==(const BitVector& other) const { return m_words == other.m_words; }
+        bool operator!=(const BitVector& other) const { return m_words != other.m_words; }
+        //calls f with each set bit in increasing order
+        template <typename F>
+        void for_each(F f) const {
+            for (size_t i = 0; i < m_words.size(); i++) {
+                for (uint64_t w = m_words[i]; w != 0; w &= w - 1) {
+                    f(i * 64 + __builtin_ctzll(w));
+                }
+            }
+        }
+    private:
+        //bits past m_size stay clear so whole-word compares and set_all agree
+        void clear_padding() {
+            if (m_size % 64 != 0) {
+                m_words.back() &= (1ull << (m_size % 64)) - 1;
+            }
+        }
+};
+
+#endif //BIT_VECTOR_HPP
@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <filesystem>
+#include <unistd.h>
+#include <thread>
+#include <functional>
+
+#include "build_cache.hpp"
+#include "utility.hpp"
+
+uint64_t BuildCache::key(std::string_view source, const std::vector<uint64_t>& deps) const {
+    std::string bytes(VERSION);
+    bytes.push_back('\0');
+    bytes.append(source);
+    for (uint64_t d: deps) {
+        bytes.append((const char*)&d, sizeof(d));
+    }
+    return hash_bytes(bytes);
+}
+
+//entries keep the output's extension so a .tmd and an .asm with the same key never collide
+std::string BuildCache::entry_path(uint64_t key, const std::string& output_file) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return m_dir + "/" + name + std::filesystem::path(output_file).extension().string();
+}
+
+bool BuildCache::fetch(uint64_t key, const std::string& output_file) const {
+    std::error_code ec;
+    std::filesystem::copy_file(entry_path(key, output_file), output_file, std::filesystem::copy_options::overwrite_existing, ec);
+    return !ec;
+}
+
+//a failed store only costs a rebuild next time, so errors are ignored
+void BuildCache::store(uint64_t key, const std::string& output_file) const {
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+
+    std::string entry = entry_path(key, output_file);
+    std::string tmp = entry + ".tmp" + std::to_string(getpid()) + "_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    std::filesystem::copy_file(output_file, tmp, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) return;
+    std::filesystem::rename(tmp, entry, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+    }
+}
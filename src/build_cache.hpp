@@ -0,0 +1,30 @@
+#ifndef BUILD_CACHE_HPP
+#define BUILD_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * On-disk cache of generated .asm and .obj files.
+ * Entries are keyed by a hash of everything that can change the output: the input's contents,
+ * the compiler version and, for .tmd modules, the interfaces of the imported modules.
+ * Entries are written under a temporary name and renamed into place, so modules built
+ * in parallel never read a partially written entry.
+ */
+class BuildCache {
+    public:
+        //bump whenever a change to the compiler changes generated code
+        static constexpr std::string_view VERSION = "tama-7";
+        bool m_enabled = false;
+        std::string m_dir = ".tama_cache";
+    public:
+        uint64_t key(std::string_view source, const std::vector<uint64_t>& deps) const;
+        bool fetch(uint64_t key, const std::string& output_file) const;
+        void store(uint64_t key, const std::string& output_file) const;
+    private:
+        std::string entry_path(uint64_t key, const std::string& output_file) const;
+};
+
+#endif //BUILD_CACHE_HPP
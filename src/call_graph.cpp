@@ -0,0 +1,30 @@
+#include <algorithm>
+
+#include "call_graph.hpp"
+
+
+CallGraph::CallGraph(const std::vector<TacFunction>& functions) {
+    for (uint32_t f = 0; f < functions.size(); f++) {
+        m_index.insert({functions[f].m_name, f});
+        m_nodes.push_back(CallNode(functions[f].m_name));
+    }
+
+    for (uint32_t f = 0; f < functions.size(); f++) {
+        const TacFunction& fn = functions[f];
+        for (BlockId b = 0; b < fn.m_blocks.size(); b++) {
+            for (InstrId i = fn.m_blocks[b].m_first; i != INSTR_NONE; i = fn.next(i)) {
+                const TacQuad& q = fn.quad(i);
+                if (q.m_op != TacT::CallNil && q.m_op != TacT::CallResult) continue;
+
+                uint32_t callee = function_index(q.opd2().m_value);
+                if (callee == NONE) continue;
+                m_nodes[f].m_calls.push_back({b, callee});
+
+                std::vector<uint32_t>& callers = m_nodes[callee].m_callers;
+                if (std::find(callers.begin(), callers.end(), f) == callers.end()) {
+                    callers.push_back(f);
+                }
+            }
+        }
+    }
+}
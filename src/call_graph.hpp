@@ -0,0 +1,40 @@
+#ifndef CALL_GRAPH_HPP
+#define CALL_GRAPH_HPP
+
+#include <vector>
+#include <unordered_map>
+#include "tac.hpp"
+
+//a call from m_block of the caller to the function at index m_callee
+struct CallSite {
+    BlockId m_block;
+    uint32_t m_callee;
+};
+
+class CallNode {
+    public:
+        SymbolId m_name;
+        std::vector<CallSite> m_calls; //calls to functions imported from other modules are left out
+        std::vector<uint32_t> m_callers;
+        CallNode(SymbolId name): m_name(name) {}
+};
+
+/*
+ * Which functions of a module call which, built from CallNil and CallResult.
+ * Nodes are indexed like the module's functions.
+ */
+class CallGraph {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+    public:
+        explicit CallGraph(const std::vector<TacFunction>& functions);
+        uint32_t function_index(SymbolId name) const {
+            std::unordered_map<SymbolId, uint32_t>::const_iterator it = m_index.find(name);
+            return it == m_index.end() ? NONE : it->second;
+        }
+    public:
+        std::vector<CallNode> m_nodes;
+        std::unordered_map<SymbolId, uint32_t> m_index; //function name -> node
+};
+
+#endif //CALL_GRAPH_HPP
@@ -0,0 +1,148 @@
+#include <cstring>
+
+#include "char_scanner.hpp"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define TMD_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+static inline bool in_class(char c, CharScanner::Class k) {
+    switch (k) {
+        case CharScanner::SPACE:
+            return c == ' ';
+        case CharScanner::WORD:
+            return ('0' <= c && c <= '9') || ('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || c == '_';
+        case CharScanner::DIGIT:
+            return '0' <= c && c <= '9';
+        default:
+            return false;
+    }
+}
+
+#ifdef TMD_X86_SIMD
+
+/*
+ * Bytes >= 0x80 compare as negative with the signed compares below, so they
+ * never fall in a class, which matches the scalar path.
+ */
+
+static inline __m128i sse2_in_range(__m128i c, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), c));
+}
+
+static void sse2_classify(const char* p, uint64_t* masks) {
+    masks[CharScanner::SPACE] = 0;
+    masks[CharScanner::WORD] = 0;
+    masks[CharScanner::DIGIT] = 0;
+
+    for (int i = 0; i < 4; i++) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(p + i * 16));
+        __m128i digit = sse2_in_range(c, '0', '9');
+        __m128i alpha = sse2_in_range(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i word = _mm_or_si128(_mm_or_si128(digit, alpha), _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+        __m128i space = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+
+        masks[CharScanner::SPACE] |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << (i * 16);
+        masks[CharScanner::WORD] |= (uint64_t)(uint16_t)_mm_movemask_epi8(word) << (i * 16);
+        masks[CharScanner::DIGIT] |= (uint64_t)(uint16_t)_mm_movemask_epi8(digit) << (i * 16);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_in_range(__m256i c, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+}
+
+__attribute__((target("avx2")))
+static void avx2_classify(const char* p, uint64_t* masks) {
+    masks[CharScanner::SPACE] = 0;
+    masks[CharScanner::WORD] = 0;
+    masks[CharScanner::DIGIT] = 0;
+
+    for (int i = 0; i < 2; i++) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(p + i * 32));
+        __m256i digit = avx2_in_range(c, '0', '9');
+        __m256i alpha = avx2_in_range(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i word = _mm256_or_si256(_mm256_or_si256(digit, alpha), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+        __m256i space = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '));
+
+        masks[CharScanner::SPACE] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << (i * 32);
+        masks[CharScanner::WORD] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(word) << (i * 32);
+        masks[CharScanner::DIGIT] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(digit) << (i * 32);
+    }
+}
+
+#endif //TMD_X86_SIMD
+
+size_t CharScanner::scalar_run(size_t i, Class c) {
+    size_t start = i;
+    while (i < m_size && in_class(m_base[i], c)) i++;
+    return i - start;
+}
+
+void CharScanner::load_block(size_t block) {
+    m_block = block;
+    if (block + BLOCK_SIZE <= m_size) {
+        m_classify(m_base + block, m_masks);
+    } else {
+        //last partial block: zero padding never matches a class, so runs stop at the end of the source
+        char tail[BLOCK_SIZE];
+        memset(tail, 0, BLOCK_SIZE);
+        memcpy(tail, m_base + block, m_size - block);
+        m_classify(tail, m_masks);
+    }
+}
+
+size_t CharScanner::block_run(size_t i, Class c) {
+    size_t start = i;
+    while (i < m_size) {
+        size_t block = i & ~(BLOCK_SIZE - 1);
+        if (block != m_block) load_block(block);
+
+        uint64_t stop = ~m_masks[c] >> (i - block);
+        if (stop) return i + __builtin_ctzll(stop) - start;
+        i = block + BLOCK_SIZE;
+    }
+    return m_size - start;
+}
+
+bool CharScanner::supported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef TMD_X86_SIMD
+        case Isa::SSE2:
+            return true;
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+CharScanner CharScanner::create(Isa isa) {
+    CharScanner s;
+    s.m_isa = supported(isa) ? isa : Isa::Scalar;
+#ifdef TMD_X86_SIMD
+    if (s.m_isa == Isa::AVX2) s.m_classify = avx2_classify;
+    if (s.m_isa == Isa::SSE2) s.m_classify = sse2_classify;
+#endif
+    return s;
+}
+
+CharScanner::Isa CharScanner::best() {
+    if (supported(Isa::AVX2)) return Isa::AVX2;
+    if (supported(Isa::SSE2)) return Isa::SSE2;
+    return Isa::Scalar;
+}
+
+const char* CharScanner::isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX2: return "avx2";
+        default: return "<unknown>";
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef CHAR_SCANNER_HPP
+#define CHAR_SCANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Byte-class scanning used by the Lexer to find token boundaries.
+ * The SSE2/AVX2 paths classify the source 64 bytes at a time into space, word
+ * and digit bitmasks, so finding the end of a run is a shift and a count of
+ * trailing zeros on the cached block. The widest path the CPU supports is
+ * picked at runtime, and the scalar path walks byte by byte.
+ */
+class CharScanner {
+    public:
+        enum class Isa {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+        enum Class {
+            SPACE = 0,
+            WORD,   //[A-Za-z0-9_]
+            DIGIT,
+            CLASS_COUNT
+        };
+        static constexpr size_t BLOCK_SIZE = 64;
+    private:
+        Isa m_isa = Isa::Scalar;
+        void (*m_classify)(const char* p, uint64_t* masks) = nullptr;
+        const char* m_base = nullptr;
+        size_t m_size = 0;
+        size_t m_block = SIZE_MAX;
+        uint64_t m_masks[CLASS_COUNT];
+    public:
+        static CharScanner create(Isa isa);
+        static bool supported(Isa isa);
+        static Isa best();
+        static const char* isa_name(Isa isa);
+
+        Isa isa() const {
+            return m_isa;
+        }
+        void reset(const char* p, size_t n) {
+            m_base = p;
+            m_size = n;
+            m_block = SIZE_MAX;
+        }
+        //length of the run of 'c' bytes starting at offset i
+        size_t run(size_t i, Class c) {
+            if (m_isa == Isa::Scalar) return scalar_run(i, c);
+
+            //fast path: the run ends inside the cached block
+            size_t block = i & ~(BLOCK_SIZE - 1);
+            if (block == m_block) {
+                uint64_t stop = ~m_masks[c] >> (i - block);
+                if (stop) return __builtin_ctzll(stop);
+            }
+            return block_run(i, c);
+        }
+    private:
+        size_t scalar_run(size_t i, Class c);
+        size_t block_run(size_t i, Class c);
+        void load_block(size_t block);
+};
+
+#endif //CHAR_SCANNER_HPP
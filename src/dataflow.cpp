@@ -0,0 +1,149 @@
+#include <deque>
+#include <algorithm>
+
+#include "dataflow.hpp"
+
+
+VarIndex::VarIndex(const TacFunction& fn) {
+    for (const TacBlock& b: fn.m_blocks) {
+        for (InstrId i = b.m_first; i != INSTR_NONE; i = fn.next(i)) {
+            const TacQuad& q = fn.quad(i);
+            for (int o = 0; o < 3; o++) {
+                if (q.m_kinds[o] == OpdKind::Var && m_ids.find(q.m_values[o]) == m_ids.end()) {
+                    m_ids.insert({q.m_values[o], (uint32_t)m_names.size()});
+                    m_names.push_back(q.m_values[o]);
+                }
+            }
+        }
+    }
+}
+
+DataflowResult solve_dataflow(const ControlFlowGraph& cfg, Direction dir, Meet meet, size_t bits,
+                              const std::vector<BitVector>& gen, const std::vector<BitVector>& kill,
+                              const BitVector& boundary) {
+    size_t n = cfg.m_blocks.size();
+    bool forward = dir == Direction::Forward;
+
+    //the set each block meets into: in for forward problems, out for backward ones
+    DataflowResult r;
+    r.m_in.assign(n, BitVector(bits, meet == Meet::Intersect));
+    r.m_out.assign(n, BitVector(bits, meet == Meet::Intersect));
+    std::vector<BitVector>& met = forward ? r.m_in : r.m_out;
+    std::vector<BitVector>& result = forward ? r.m_out : r.m_in;
+
+    std::vector<BlockId> order = cfg.reverse_postorder();
+    if (!forward) {
+        std::reverse(order.begin(), order.end());
+    }
+    std::deque<BlockId> work(order.begin(), order.end());
+    std::vector<bool> queued(n, true);
+
+    while (!work.empty()) {
+        BlockId b = work.front();
+        work.pop_front();
+        queued[b] = false;
+
+        const std::vector<BlockId>& sources = forward ? cfg.m_blocks[b].m_preds : cfg.m_blocks[b].m_succs;
+        bool at_boundary = forward ? b == ControlFlowGraph::ENTRY : sources.empty();
+        BitVector in(bits, meet == Meet::Intersect && !at_boundary && !sources.empty());
+        if (at_boundary) {
+            in = boundary;
+        }
+        for (BlockId s: sources) {
+            if (meet == Meet::Union) {
+                in.union_with(result[s]);
+            } else {
+                in.intersect_with(result[s]);
+            }
+        }
+        met[b] = in;
+
+        in.subtract(kill[b]);
+        in.union_with(gen[b]);
+        if (in == result[b]) continue;
+        result[b] = std::move(in);
+
+        const std::vector<BlockId>& targets = forward ? cfg.m_blocks[b].m_succs : cfg.m_blocks[b].m_preds;
+        for (BlockId t: targets) {
+            if (!queued[t]) {
+                queued[t] = true;
+                work.push_back(t);
+            }
+        }
+    }
+    return r;
+}
+
+Liveness::Liveness(const TacFunction& fn, const ControlFlowGraph& cfg): m_vars(fn) {
+    size_t n = fn.m_blocks.size();
+    std::vector<BitVector> gen(n, BitVector(m_vars.size()));
+    std::vector<BitVector> kill(n, BitVector(m_vars.size()));
+
+    //walking each block backwards leaves gen holding the reads not preceded by a write
+    for (BlockId b = 0; b < n; b++) {
+        for (InstrId i = fn.m_blocks[b].m_last; i != INSTR_NONE; i = fn.m_instrs[i].m_prev) {
+            const TacQuad& q = fn.quad(i);
+            if (q.defines_target() && q.target().m_kind == OpdKind::Var) {
+                uint32_t v = m_vars.id(q.m_values[TacQuad::TARGET]);
+                kill[b].set(v);
+                gen[b].reset(v);
+            }
+            for_each_use(q, [&](SymbolId name) { gen[b].set(m_vars.id(name)); });
+        }
+    }
+
+    DataflowResult r = solve_dataflow(cfg, Direction::Backward, Meet::Union, m_vars.size(), gen, kill, BitVector(m_vars.size()));
+    m_in = std::move(r.m_in);
+    m_out = std::move(r.m_out);
+}
+
+void Liveness::transfer(const TacQuad& q, BitVector* live) const {
+    if (q.defines_target() && q.target().m_kind == OpdKind::Var) {
+        live->reset(m_vars.id(q.m_values[TacQuad::TARGET]));
+    }
+    for_each_use(q, [&](SymbolId name) { live->set(m_vars.id(name)); });
+}
+
+ReachingDefinitions::ReachingDefinitions(const TacFunction& fn, const ControlFlowGraph& cfg): m_vars(fn) {
+    size_t n = fn.m_blocks.size();
+    m_var_defs.resize(m_vars.size());
+    std::vector<std::vector<uint32_t>> block_defs(n);
+    for (BlockId b = 0; b < n; b++) {
+        for (InstrId i = fn.m_blocks[b].m_first; i != INSTR_NONE; i = fn.next(i)) {
+            const TacQuad& q = fn.quad(i);
+            if (!q.defines_target() || q.target().m_kind != OpdKind::Var) continue;
+
+            uint32_t d = m_defs.size();
+            uint32_t v = m_vars.id(q.m_values[TacQuad::TARGET]);
+            m_defs.push_back(i);
+            m_def_var.push_back(v);
+            m_var_defs[v].push_back(d);
+            block_defs[b].push_back(d);
+        }
+    }
+
+    std::vector<BitVector> gen(n, BitVector(m_defs.size()));
+    std::vector<BitVector> kill(n, BitVector(m_defs.size()));
+    //each variable the block writes kills all of its definitions, and only the block's last one survives
+    std::vector<uint32_t> last(m_vars.size(), UINT32_MAX);
+    std::vector<uint32_t> written;
+    for (BlockId b = 0; b < n; b++) {
+        written.clear();
+        for (uint32_t d: block_defs[b]) {
+            uint32_t v = m_def_var[d];
+            if (last[v] == UINT32_MAX) written.push_back(v);
+            last[v] = d;
+        }
+        for (uint32_t v: written) {
+            for (uint32_t d: m_var_defs[v]) {
+                kill[b].set(d);
+            }
+            gen[b].set(last[v]);
+            last[v] = UINT32_MAX;
+        }
+    }
+
+    DataflowResult r = solve_dataflow(cfg, Direction::Forward, Meet::Union, m_defs.size(), gen, kill, BitVector(m_defs.size()));
+    m_in = std::move(r.m_in);
+    m_out = std::move(r.m_out);
+}
@@ -0,0 +1,95 @@
+#ifndef DATAFLOW_HPP
+#define DATAFLOW_HPP
+
+#include <vector>
+#include <unordered_map>
+
+#include "tac.hpp"
+#include "ControlFlowGraph.hpp"
+#include "bit_vector.hpp"
+
+/*
+ * Dense numbering of the variables (Var operands) one function uses, so they can index bit vectors.
+ */
+class VarIndex {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+    public:
+        std::vector<SymbolId> m_names;
+        std::unordered_map<SymbolId, uint32_t> m_ids;
+    public:
+        explicit VarIndex(const TacFunction& fn);
+        uint32_t id(SymbolId name) const {
+            std::unordered_map<SymbolId, uint32_t>::const_iterator it = m_ids.find(name);
+            return it == m_ids.end() ? NONE : it->second;
+        }
+        size_t size() const { return m_names.size(); }
+};
+
+//calls f with the SymbolId of every variable q reads
+template <typename F>
+void for_each_use(const TacQuad& q, F f) {
+    for (int i = 0; i < 3; i++) {
+        if (i == TacQuad::TARGET && q.defines_target()) continue;
+        if (q.m_kinds[i] == OpdKind::Var) f(q.m_values[i]);
+    }
+}
+
+enum class Direction {
+    Forward,
+    Backward
+};
+
+enum class Meet {
+    Union,
+    Intersect
+};
+
+struct DataflowResult {
+    std::vector<BitVector> m_in;
+    std::vector<BitVector> m_out;
+};
+
+/*
+ * Worklist solver for gen/kill bit-vector problems over one function's CFG.
+ * Forward problems compute out = gen | (in - kill) with in the meet of the predecessors' out;
+ * backward problems the mirror image. The boundary set flows into the entry block (forward)
+ * or out of every block without successors (backward).
+ * Blocks start on the worklist in reverse postorder (postorder when backward), so acyclic
+ * code settles in one pass and each loop needs only as many extra visits as its nesting.
+ */
+DataflowResult solve_dataflow(const ControlFlowGraph& cfg, Direction dir, Meet meet, size_t bits,
+                              const std::vector<BitVector>& gen, const std::vector<BitVector>& kill,
+                              const BitVector& boundary);
+
+/*
+ * Variables live at block boundaries. A variable is live if some path reads it before writing it.
+ */
+class Liveness {
+    public:
+        VarIndex m_vars;
+        std::vector<BitVector> m_in;
+        std::vector<BitVector> m_out;
+    public:
+        Liveness(const TacFunction& fn, const ControlFlowGraph& cfg);
+        //steps live from just after q to just before it
+        void transfer(const TacQuad& q, BitVector* live) const;
+};
+
+/*
+ * Definitions (quads that write a variable) reaching block boundaries.
+ * Bit i stands for the definition at m_defs[i]. Parameters have no definition inside the function.
+ */
+class ReachingDefinitions {
+    public:
+        VarIndex m_vars;
+        std::vector<InstrId> m_defs;
+        std::vector<uint32_t> m_def_var; //variable each definition writes
+        std::vector<std::vector<uint32_t>> m_var_defs; //definitions of each variable
+        std::vector<BitVector> m_in;
+        std::vector<BitVector> m_out;
+    public:
+        ReachingDefinitions(const TacFunction& fn, const ControlFlowGraph& cfg);
+};
+
+#endif //DATAFLOW_HPP
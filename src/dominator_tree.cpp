@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <utility>
+
+#include "dominator_tree.hpp"
+
+
+DominatorTree::DominatorTree(const ControlFlowGraph& cfg, bool post): m_post(post) {
+    size_t n = cfg.m_blocks.size();
+    std::vector<std::vector<BlockId>> succs(n);
+    std::vector<std::vector<BlockId>> preds(n);
+    for (BlockId b = 0; b < n; b++) {
+        succs[b] = cfg.m_blocks[b].m_succs;
+        preds[b] = cfg.m_blocks[b].m_preds;
+    }
+
+    if (!post) {
+        m_root = ControlFlowGraph::ENTRY;
+    } else {
+        //walk the reversed graph from a virtual exit joined to every block that leaves the function
+        m_root = n;
+        succs.swap(preds);
+        succs.push_back({});
+        preds.push_back({});
+        for (BlockId b = 0; b < n; b++) {
+            if (cfg.m_blocks[b].m_succs.empty()) {
+                succs[m_root].push_back(b);
+                preds[b].push_back(m_root);
+            }
+        }
+    }
+
+    build(succs, preds);
+}
+
+void DominatorTree::build(const std::vector<std::vector<BlockId>>& succs, const std::vector<std::vector<BlockId>>& preds) {
+    size_t n = succs.size();
+    m_idom.assign(n, BLOCK_NONE);
+    m_children.assign(n, {});
+    m_enter.assign(n, 0);
+    m_leave.assign(n, 0);
+    m_order.clear();
+    if (m_root >= n) return;
+
+    //postorder numbers by iterative depth-first search
+    std::vector<uint32_t> po(n, UINT32_MAX);
+    std::vector<bool> seen(n, false);
+    std::vector<std::pair<BlockId, size_t>> stack;
+    stack.push_back({m_root, 0});
+    seen[m_root] = true;
+    while (!stack.empty()) {
+        std::pair<BlockId, size_t>& top = stack.back();
+        if (top.second < succs[top.first].size()) {
+            BlockId next = succs[top.first][top.second++];
+            if (!seen[next]) {
+                seen[next] = true;
+                stack.push_back({next, 0});
+            }
+        } else {
+            po[top.first] = m_order.size();
+            m_order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(m_order.begin(), m_order.end());
+
+    auto intersect = [&](BlockId a, BlockId b) {
+        while (a != b) {
+            while (po[a] < po[b]) a = m_idom[a];
+            while (po[b] < po[a]) b = m_idom[b];
+        }
+        return a;
+    };
+
+    m_idom[m_root] = m_root;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (BlockId b: m_order) {
+            if (b == m_root) continue;
+            BlockId idom = BLOCK_NONE;
+            for (BlockId p: preds[b]) {
+                if (m_idom[p] == BLOCK_NONE) continue;
+                idom = idom == BLOCK_NONE ? p : intersect(p, idom);
+            }
+            if (m_idom[b] != idom) {
+                m_idom[b] = idom;
+                changed = true;
+            }
+        }
+    }
+
+    for (BlockId b: m_order) {
+        if (b != m_root) {
+            m_children[m_idom[b]].push_back(b);
+        }
+    }
+
+    uint32_t clock = 0;
+    std::vector<std::pair<BlockId, size_t>> walk;
+    walk.push_back({m_root, 0});
+    m_enter[m_root] = clock++;
+    while (!walk.empty()) {
+        std::pair<BlockId, size_t>& top = walk.back();
+        if (top.second < m_children[top.first].size()) {
+            BlockId child = m_children[top.first][top.second++];
+            m_enter[child] = clock++;
+            walk.push_back({child, 0});
+        } else {
+            m_leave[top.first] = clock++;
+            walk.pop_back();
+        }
+    }
+}
+
+std::vector<std::vector<BlockId>> DominatorTree::frontiers(const ControlFlowGraph& cfg) const {
+    size_t n = m_idom.size();
+    std::vector<std::vector<BlockId>> df(n);
+    for (BlockId b = 0; b < n; b++) {
+        if (b == m_root || !reachable(b)) continue;
+        //the predecessors in the graph the tree was built over; blocks joined only to the virtual exit have one
+        const std::vector<BlockId>& preds = m_post ? cfg.m_blocks[b].m_succs : cfg.m_blocks[b].m_preds;
+        if (preds.size() < 2) continue;
+
+        //every block from a predecessor up to (not including) b's idom reaches b without dominating it
+        for (BlockId p: preds) {
+            if (!reachable(p)) continue;
+            for (BlockId runner = p; runner != m_idom[b]; runner = m_idom[runner]) {
+                if (!df[runner].empty() && df[runner].back() == b) break;
+                df[runner].push_back(b);
+            }
+        }
+    }
+    return df;
+}
@@ -0,0 +1,61 @@
+#ifndef DOMINATOR_TREE_HPP
+#define DOMINATOR_TREE_HPP
+
+#include <vector>
+#include <utility>
+#include "ControlFlowGraph.hpp"
+
+/*
+ * Dominator or post-dominator tree of one function's control-flow graph, computed with the
+ * Cooper-Harvey-Kennedy iterative algorithm over reverse postorder.
+ *
+ * Post-dominators are taken from a virtual exit, numbered root() == block count, that every block
+ * without successors flows into. Blocks the root can't reach (for post-dominators: blocks that
+ * never reach the exit, such as infinite loops) have no immediate dominator and dominate nothing.
+ */
+class DominatorTree {
+    private:
+        BlockId m_root;
+        bool m_post;
+        std::vector<BlockId> m_idom;
+        std::vector<std::vector<BlockId>> m_children;
+        std::vector<BlockId> m_order; //reverse postorder from the root
+        std::vector<uint32_t> m_enter; //m_enter/m_leave number the tree depth first, so a dominates b when b's interval nests in a's
+        std::vector<uint32_t> m_leave;
+    public:
+        explicit DominatorTree(const ControlFlowGraph& cfg, bool post = false);
+        BlockId root() const { return m_root; } //the entry block, or the virtual exit
+        //BLOCK_NONE for the root and for unreachable blocks
+        BlockId idom(BlockId b) const { return b == m_root ? BLOCK_NONE : m_idom[b]; }
+        const std::vector<BlockId>& children(BlockId b) const { return m_children[b]; }
+        const std::vector<BlockId>& order() const { return m_order; }
+        bool reachable(BlockId b) const { return m_idom[b] != BLOCK_NONE; }
+        bool dominates(BlockId a, BlockId b) const {
+            return reachable(a) && reachable(b) && m_enter[a] <= m_enter[b] && m_leave[b] <= m_leave[a];
+        }
+        //calls enter(b) for each block of the tree in depth-first preorder, and leave(b) once b's subtree is done
+        template <typename Enter, typename Leave>
+        void walk(Enter enter, Leave leave) const {
+            if (m_root >= m_children.size()) return;
+            std::vector<std::pair<BlockId, size_t>> stack;
+            enter(m_root);
+            stack.push_back({m_root, 0});
+            while (!stack.empty()) {
+                std::pair<BlockId, size_t>& top = stack.back();
+                if (top.second < m_children[top.first].size()) {
+                    BlockId child = m_children[top.first][top.second++];
+                    enter(child);
+                    stack.push_back({child, 0});
+                } else {
+                    leave(top.first);
+                    stack.pop_back();
+                }
+            }
+        }
+        //the blocks where each block's dominance ends: joins it reaches without strictly dominating them
+        std::vector<std::vector<BlockId>> frontiers(const ControlFlowGraph& cfg) const;
+    private:
+        void build(const std::vector<std::vector<BlockId>>& succs, const std::vector<std::vector<BlockId>>& preds);
+};
+
+#endif //DOMINATOR_TREE_HPP
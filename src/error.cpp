@@ -4,8 +4,6 @@
 
 #include "error.hpp"
 
-ErrorMsgs ems;
-
 void ErrorMsgs::add_error(int line, const char* format, ...) {
     va_list ap;
     va_start(ap, format);
@@ -17,6 +15,10 @@ void ErrorMsgs::add_error(int line, const char* format, ...) {
     m_errors.push_back({std::string(s), line});
 }
 
+void ErrorMsgs::add_errors(const ErrorMsgs& other) {
+    m_errors.insert(m_errors.end(), other.m_errors.begin(), other.m_errors.end());
+}
+
 void ErrorMsgs::sort() {
     for (int end = m_errors.size() - 1; end > 0; end--) {
         for (int i = 0; i < end; i++) {
@@ -14,12 +14,11 @@ class ErrorMsgs {
         std::vector<Error> m_errors;
     public:
         void add_error(int line, const char* format, ...);
+        void add_errors(const ErrorMsgs& other);
         void sort();
         void print();
         bool has_errors();
 };
 
-extern ErrorMsgs ems;
-
 
 #endif //TMD_ERROR_HPP
@@ -0,0 +1,38 @@
+#include <cstring>
+#include <mutex>
+
+#include "interner.hpp"
+
+Interner interner;
+
+Interner::Interner() {
+    m_names.push_back(std::string_view(""));
+    m_ids.insert({std::string_view(""), EMPTY});
+}
+
+SymbolId Interner::intern(std::string_view name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        std::unordered_map<std::string_view, SymbolId>::iterator it = m_ids.find(name);
+        if (it != m_ids.end()) {
+            return it->second;
+        }
+    }
+
+    //another thread may have added the name between dropping the shared lock and taking this one
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    std::unordered_map<std::string_view, SymbolId>::iterator it = m_ids.find(name);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+
+    char* copy = (char*)m_arena.alloc(name.size() + 1, 1);
+    memcpy(copy, name.data(), name.size());
+    copy[name.size()] = '\0';
+    std::string_view stored(copy, name.size());
+
+    SymbolId id = m_names.size();
+    m_names.push_back(stored);
+    m_ids.insert({stored, id});
+    return id;
+}
@@ -0,0 +1,51 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <vector>
+
+#include "arena.hpp"
+
+typedef uint32_t SymbolId;
+
+/*
+ * Maps every distinct name to a 32-bit id so symbol tables can be keyed by integers.
+ * Id 0 is always the empty string. Interned text lives in an Arena and is never freed,
+ * and is stored NUL-terminated so it can be handed to printf-style writers without a copy.
+ * Modules are compiled on several threads against the one global interner, so lookups take
+ * a shared lock and only inserting a new name takes the exclusive one.
+ */
+class Interner {
+    public:
+        static constexpr SymbolId EMPTY = 0;
+    private:
+        Arena m_arena;
+        std::unordered_map<std::string_view, SymbolId> m_ids;
+        std::vector<std::string_view> m_names;
+        mutable std::shared_mutex m_mutex;
+    public:
+        Interner();
+        SymbolId intern(std::string_view name);
+        std::string_view view(SymbolId id) const {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            return m_names[id];
+        }
+        const char* c_str(SymbolId id) const {
+            return view(id).data();
+        }
+        std::string str(SymbolId id) const {
+            return std::string(view(id));
+        }
+        size_t size() const {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            return m_names.size();
+        }
+};
+
+extern Interner interner;
+
+#endif //INTERNER_HPP
@@ -3,29 +3,40 @@
 #include "lexer.hpp"
 #include "error.hpp"
 
-std::vector<struct Token> Lexer::lex(const std::string& code, const std::vector<struct ReservedWordNew>& reserved_words) {
-    m_code = code;
-    m_line = 1;
+void Lexer::init(SourceBuffer& source, const KeywordTable& reserved_words, ErrorMsgs& ems) {
+    m_source = &source;
+    m_ems = &ems;
+    m_code = source.view();
     m_current = 0;
-    m_reserved_words = reserved_words;
-    m_tokens = std::vector<struct Token>();
+    m_reserved_words = &reserved_words;
+    m_scanner.reset(m_code.data(), m_code.size());
+}
+
+//returns T_EOF once the source is exhausted, and keeps returning it on later calls
+struct Token Lexer::next() {
+    while (1) {
+        skip_ws();
+        if (m_current >= m_code.size())
+            return {(uint32_t)m_code.size(), 0, T_EOF};
 
-    while (m_current < m_code.size()) {
         struct Token t = next_token();
         if (t.type != T_NEWLINE)
-            m_tokens.push_back(t);
-        else
-            m_line++;
-    }
+            return t;
 
-    m_tokens.push_back({T_EOF, NULL, 0, m_line});
+        m_source->add_newline(t.off);
+    }
+}
 
-    return m_tokens;
+uint16_t Lexer::clamp_len(size_t len) {
+    if (len > UINT16_MAX) {
+        m_ems->add_error(m_source->line_at(m_current), "Token Error: Token longer than %d characters!", UINT16_MAX);
+        return UINT16_MAX;
+    }
+    return len;
 }
 
 void Lexer::skip_ws() {
-    while (m_code[m_current] == ' ')
-        m_current++;
+    m_current += m_scanner.run(m_current, CharScanner::SPACE);
 }
 
 bool Lexer::is_digit(char c) {
@@ -39,50 +50,37 @@ bool Lexer::is_char(char c) {
 struct Token Lexer::read_word() {
     //TODO: use {} constructor
     struct Token t;
-    t.start = &m_code[m_current];
-    t.len = 1;
-    t.line = m_line;
-
-    while (1) {
-        char next = m_code[m_current + t.len];
-        if (!(is_digit(next) || is_char(next) || next == '_'))
-            break;
-        t.len++;
-    }
-
-    t.type = T_IDENTIFIER;
-    for (int i = 0; i < m_reserved_words.size(); i++) {
-        struct ReservedWordNew *rw = &m_reserved_words[i];
-        if (rw->m_string.size() == t.len && strncmp(rw->m_string.c_str(), t.start, t.len) == 0) {
-            t.type = rw->m_token_type;
-            break;
-        } 
-    }
+    t.off = m_current;
+    t.len = clamp_len(1 + m_scanner.run(m_current + 1, CharScanner::WORD));
+    t.type = m_reserved_words->find(m_code.data() + t.off, t.len);
 
     return t;
 }
 
 struct Token Lexer::read_number() {
     struct Token t;
-    t.start = &m_code[m_current];
-    t.len = 1;
-    t.line = m_line;
-    bool has_decimal = *t.start == '.';
+    t.off = m_current;
+    size_t len = 1;
+    bool has_decimal = peek(m_current) == '.';
     bool is_hex = false;
 
-    if (m_code[m_current] == '0' && m_code[m_current + 1] == 'x') {
+    if (peek(m_current) == '0' && peek(m_current + 1) == 'x') {
         is_hex = true;
-        t.len++;
+        len++;
     }
 
     while (1) {
-        char next = m_code[m_current + t.len];
+        if (!is_hex) {
+            len += m_scanner.run(m_current + len, CharScanner::DIGIT);
+        }
+
+        char next = peek(m_current + len);
         if (is_digit(next) || (is_hex && is_char(next))) {
-            t.len++;
+            len++;
         } else if (next == '.') {
-            t.len++;
+            len++;
             if (has_decimal) {
-                ems.add_error(m_line, "Token Error: Too many decimals!");
+                m_ems->add_error(m_source->line_at(m_current), "Token Error: Too many decimals!");
             } else {
                 has_decimal = true;
             }
@@ -91,55 +89,53 @@ struct Token Lexer::read_number() {
         }
     }
 
+    t.len = clamp_len(len);
     t.type = has_decimal ? T_FLOAT : is_hex ? T_HEX : T_INT;
     return t;
 }
 
 struct Token Lexer::next_token() {
-    skip_ws();
-
     struct Token t;
-    t.line = m_line;
-    char c = m_code[m_current];
+    char c = peek(m_current);
     switch (c) {
         case '\n':
             t.type = T_NEWLINE;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '+':
             t.type = T_PLUS;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '-':
             t.type = T_MINUS;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '*':
             t.type = T_STAR;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '/':
             t.type = T_SLASH;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '(':
             t.type = T_L_PAREN;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case ')':
             t.type = T_R_PAREN;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case ':':
-            t.start = &m_code[m_current];
-            if (m_current + 1 < m_code.size() && m_code[m_current + 1] == ':') {
+            t.off = m_current;
+            if (peek(m_current + 1) == ':') {
                 t.type = T_COLON_COLON;
                 t.len = 2;
             } else {
@@ -148,8 +144,8 @@ struct Token Lexer::next_token() {
             }
             break;
         case '<':
-            t.start = &m_code[m_current];
-            if (m_current + 1 < m_code.size() && m_code[m_current + 1] == '=') {
+            t.off = m_current;
+            if (peek(m_current + 1) == '=') {
                 t.type = T_LESS_EQUAL;
                 t.len = 2;
             } else {
@@ -158,8 +154,8 @@ struct Token Lexer::next_token() {
             }
             break;
         case '>':
-            t.start = &m_code[m_current];
-            if (m_current + 1 < m_code.size() && m_code[m_current + 1] == '=') {
+            t.off = m_current;
+            if (peek(m_current + 1) == '=') {
                 t.type = T_GREATER_EQUAL;
                 t.len = 2;
             } else {
@@ -168,8 +164,8 @@ struct Token Lexer::next_token() {
             }
             break;
         case '=':
-            t.start = &m_code[m_current];
-            if (m_current + 1 < m_code.size() && m_code[m_current + 1] == '=') {
+            t.off = m_current;
+            if (peek(m_current + 1) == '=') {
                 t.type = T_EQUAL_EQUAL;
                 t.len = 2;
             } else {
@@ -178,8 +174,8 @@ struct Token Lexer::next_token() {
             }
             break;
         case '!':
-            t.start = &m_code[m_current];
-            if (m_current + 1 < m_code.size() && m_code[m_current + 1] == '=') {
+            t.off = m_current;
+            if (peek(m_current + 1) == '=') {
                 t.type = T_NOT_EQUAL;
                 t.len = 2;
             } else {
@@ -189,27 +185,27 @@ struct Token Lexer::next_token() {
             break;
         case '{':
             t.type = T_L_BRACE;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '}':
             t.type = T_R_BRACE;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case '[':
             t.type = T_L_BRACKET;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case ']':
             t.type = T_R_BRACKET;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         case ',':
             t.type = T_COMMA;
-            t.start = &m_code[m_current];
+            t.off = m_current;
             t.len = 1;
             break;
         default:
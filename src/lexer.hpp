@@ -2,21 +2,39 @@
 #define LEXER_HPP
 
 #include <string>
-#include <vector>
+#include <string_view>
 
 #include "token.hpp"
 #include "reserved_word.hpp"
+#include "char_scanner.hpp"
+#include "source_buffer.hpp"
+#include "error.hpp"
 
 class Lexer {
     private:
-        std::string m_code;
-        int m_line;
+        SourceBuffer* m_source;
+        ErrorMsgs* m_ems;
+        std::string_view m_code;
         int m_current;
-        std::vector<struct ReservedWordNew> m_reserved_words;
-        std::vector<struct Token> m_tokens;
+        const KeywordTable* m_reserved_words;
+        CharScanner m_scanner = CharScanner::create(CharScanner::best());
     public:
-        std::vector<struct Token> lex(const std::string& code, const std::vector<struct ReservedWordNew>& reserved_words);
+        void set_scanner(const CharScanner& scanner) {
+            m_scanner = scanner;
+        }
+        void init(SourceBuffer& source, const KeywordTable& reserved_words, ErrorMsgs& ems);
+        struct Token next();
+        const SourceBuffer& source() const {
+            return *m_source;
+        }
+        ErrorMsgs& ems() const {
+            return *m_ems;
+        }
     private:
+        char peek(int i) {
+            return i < int(m_code.size()) ? m_code[i] : '\0';
+        }
+        uint16_t clamp_len(size_t len);
         void skip_ws();
         bool is_digit(char c);
         bool is_char(char c);
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "elf.hpp"
+#include "error.hpp"
 
 class Linker {
     private:
@@ -14,6 +15,7 @@ class Linker {
         std::unordered_map<std::string, std::vector<uint8_t>> m_obj_bufs;
         std::unordered_map<std::string, int> m_code_offsets;
         static const uint32_t LOAD_ADDR = 0x08048000;
+        ErrorMsgs& m_ems;
     private:
         std::vector<uint8_t> read_binary(const std::string& input_file);
         void write_elf_executable(const std::string& output_file);
@@ -26,6 +28,7 @@ class Linker {
         void patch_program_entry();
         void apply_relocations();
     public:
+        Linker(ErrorMsgs& ems): m_ems(ems) {}
         void link(const std::vector<std::string>& input_files, const std::string& output_file);
 };
 
@@ -2,101 +2,251 @@
 #include <string.h>
 #include <stdlib.h>
 #include <random>
+#include <sstream>
 
 #include "ast.hpp"
 #include "error.hpp"
 #include "lexer.hpp"
 #include "assembler.hpp"
 #include "semant.hpp"
+#include "module_cache.hpp"
 #include "linker.hpp"
 #include "x86_frame.hpp"
 #include "x86_generator.hpp"
 #include "optimizer.hpp"
-#include "ControlFlowGraph.hpp"
+#include "ssa.hpp"
+#include "thread_pool.hpp"
+#include "build_cache.hpp"
+#include "tacb.hpp"
+#include "utility.hpp"
+
+//output of one module's compilation, kept apart so modules can be built concurrently and reported in input order
+struct ModuleResult {
+    std::ostringstream m_log;
+    ErrorMsgs m_ems;
+};
+
+//a module's key also covers the interfaces it imports, so changing an imported signature forces a rebuild
+static bool tmd_cache_key(const BuildCache& cache, const std::string& f, uint64_t* key) {
+    SourceBuffer source;
+    if (!source.open(f)) return false;
+
+    std::vector<uint64_t> deps;
+    ErrorMsgs ems; //broken imports are reported by the real compile
+    for (const std::string& path: Semant::find_imports(source)) {
+        const ModuleInterface* iface = modules.load(path, ems);
+        if (!iface || ems.has_errors()) return false;
+        deps.push_back(iface->m_interface_hash);
+    }
+    *key = cache.key(source.view(), deps);
+    return true;
+}
+
+static bool file_cache_key(const BuildCache& cache, const std::string& f, uint64_t* key) {
+    SourceBuffer source;
+    if (!source.open(f)) return false;
+    *key = cache.key(source.view(), {});
+    return true;
+}
+
+//optimizes the module's IR and writes its x86 code to asm_file
+static void generate_code(std::vector<TacFunction>* functions, std::unordered_map<SymbolId, X86Frame>* frames,
+                          const std::string& asm_file, ModuleResult* r, ThreadPool& pool) {
+    r->m_log << "Optimizing IR..." << std::endl;
+    Optimizer opt;
+    opt.eliminate_dead_code(functions);
+
+    //functions are optimized and lowered independently, then their code is joined in source order
+    r->m_log << "Generating x86 code..." << std::endl;
+    std::vector<std::vector<uint8_t>> code(functions->size());
+    pool.run(functions->size(), [&](size_t i) {
+        TacFunction* fn = &(*functions)[i];
+        //leaving SSA may add slots to the frame; each job only touches its own function's, so this is thread safe
+        std::unordered_map<SymbolId, X86Frame>::iterator frame = frames->find(fn->m_name);
+        if (frame != frames->end() && !fn->m_blocks.empty() && fn->m_blocks[0].m_first != INSTR_NONE &&
+            fn->quad(fn->m_blocks[0].m_first).m_op == TacT::FunBegin) {
+            SSATransformer ssa(fn, &frame->second);
+            ssa.construct();
+            opt.propagate_constants(&ssa);
+            opt.eliminate_common_subexpressions(&ssa);
+            opt.hoist_loop_invariants(&ssa);
+            opt.reduce_induction_variables(&ssa);
+            ssa.destruct();
+        }
+        opt.collapse_cond_jumps(fn);
+        opt.merge_adjacent_store_fetch(fn);
+        opt.simplify_algebraic_identities(fn);
+
+        X86Generator gen;
+        gen.generate_asm(*fn, frames);
+        code[i] = std::move(gen.m_buf);
+    });
+
+    X86Generator gen;
+    for (const std::vector<uint8_t>& c: code) {
+        gen.m_buf.insert(gen.m_buf.end(), c.begin(), c.end());
+    }
+    gen.write(asm_file);
+}
+
+static void compile_tmd(const std::string& f, ModuleResult* r, ThreadPool& pool, const BuildCache& cache, bool dump_tacb) {
+    std::string tacb_file = f.substr(0, f.size() - 4) + ".tacb";
+    std::string asm_file = f.substr(0, f.size() - 4) + ".asm";
+
+    uint64_t key;
+    //a cache hit would skip the front end, leaving no IR to dump
+    bool cacheable = cache.m_enabled && !dump_tacb && tmd_cache_key(cache, f, &key);
+    if (cacheable && cache.fetch(key, asm_file)) {
+        r->m_log << "Reusing cached x86 code for " << f << "..." << std::endl;
+        return;
+    }
+
+    r->m_log << "Compiling " << f << " to IR..." << std::endl;
+    std::unordered_map<SymbolId, X86Frame> frames = std::unordered_map<SymbolId, X86Frame>();
+    Semant s = Semant(&frames, r->m_ems);
+    s.generate_ir(f);
+    if (r->m_ems.has_errors()) return;
+
+    if (dump_tacb && !write_tacb(tacb_file, s.m_functions, frames)) {
+        r->m_ems.add_error(0, "Error: Could not write '%s'.", tacb_file.c_str());
+        return;
+    }
+
+    generate_code(&s.m_functions, &frames, asm_file, r, pool);
+
+    if (cacheable) {
+        cache.store(key, asm_file);
+    }
+}
+
+//starts from IR dumped by --tacb, skipping lexing, parsing and semantic analysis
+static void compile_tacb(const std::string& f, ModuleResult* r, ThreadPool& pool, const BuildCache& cache) {
+    std::string asm_file = f.substr(0, f.size() - 5) + ".asm";
+
+    uint64_t key;
+    bool cacheable = cache.m_enabled && file_cache_key(cache, f, &key);
+    if (cacheable && cache.fetch(key, asm_file)) {
+        r->m_log << "Reusing cached x86 code for " << f << "..." << std::endl;
+        return;
+    }
+
+    r->m_log << "Loading IR from " << f << "..." << std::endl;
+    TacbFile tacb;
+    if (!tacb.open(f)) {
+        r->m_ems.add_error(0, "Error: '%s' is not a valid .tacb file.", f.c_str());
+        return;
+    }
+    std::vector<TacFunction> functions;
+    std::unordered_map<SymbolId, X86Frame> frames;
+    tacb.load(&functions, &frames);
+
+    generate_code(&functions, &frames, asm_file, r, pool);
+
+    if (cacheable) {
+        cache.store(key, asm_file);
+    }
+}
+
+static void assemble_asm(const std::string& f, ModuleResult* r, const BuildCache& cache) {
+    std::string out = f.substr(0, f.size() - 4) + ".obj";
+
+    uint64_t key;
+    bool cacheable = cache.m_enabled && file_cache_key(cache, f, &key);
+    if (cacheable && cache.fetch(key, out)) {
+        r->m_log << "Reusing cached object for " << f << "..." << std::endl;
+        return;
+    }
+
+    r->m_log << "Assembling " << f << " to ELF relocatable objects..." << std::endl;
+    Assembler a(r->m_ems);
+    a.generate_obj(f, out);
+
+    if (cacheable && !r->m_ems.has_errors()) {
+        cache.store(key, out);
+    }
+}
+
+//prints each module's log in input order and stops at the first module with errors, as a serial build would
+static bool report(std::vector<ModuleResult>& results) {
+    for (ModuleResult& r: results) {
+        std::cout << r.m_log.str();
+        if (r.m_ems.has_errors()) {
+            r.m_ems.print();
+            return false;
+        }
+    }
+    return true;
+}
 
 int main (int argc, char **argv) {
 
     
     if (argc < 2) {
-        printf("Usage: tama <filename>\n");
+        printf("Usage: tama [--tmi] [--cache] [--tacb] [-jN] <filename>\n");
         exit(1);
     }
 
-    std::vector<std::string> tmd_files = std::vector<std::string>();
+    std::vector<std::string> tmd_files = std::vector<std::string>(); //.tmd and .tacb modules
     std::vector<std::string> asm_files = std::vector<std::string>();
     std::vector<std::string> obj_files = std::vector<std::string>();
+    int jobs = 1;
+    bool dump_tacb = false;
+    BuildCache cache;
 
     for (int i = 1; i < argc; i++) {
         std::string s(argv[i]);
-        if (s.ends_with(".tmd")) {
+        if (s == "--tmi") {
+            modules.m_persist = true;
+        } else if (s == "--cache") {
+            cache.m_enabled = true;
+        } else if (s == "--tacb") {
+            dump_tacb = true;
+        } else if (s.starts_with("-j") && s.size() > 2 && is_int(s.substr(2)) && atoi(s.c_str() + 2) > 0) {
+            jobs = atoi(s.c_str() + 2);
+        } else if (s.ends_with(".tmd") || s.ends_with(".tacb")) {
             tmd_files.push_back(s);
         } else if (s.ends_with(".asm")) {
             asm_files.push_back(s);
         } else if (s.ends_with(".obj")) {
             obj_files.push_back(s);
         } else {
-            printf("Usage: only .tmd, .asm and .obj files recognized\n");
+            printf("Usage: only .tmd, .tacb, .asm and .obj files, --tmi, --cache, --tacb and -jN recognized\n");
             exit(1);
         }
     }
 
+    ThreadPool pool(jobs);
 
-    
-    for (const std::string& f: tmd_files) {
-        std::string out = f.substr(0, f.size() - 4) + ".tac";
-
-        std::cout << "Compiling " << f << " to IR..." << std::endl;
-        std::unordered_map<std::string, X86Frame> frames = std::unordered_map<std::string, X86Frame>();
-        Semant s = Semant(&frames);
-        s.generate_ir(f, out);
-        if (ems.has_errors()) {
-            ems.print();
-            return 1;
-        }
-
-        std::cout << "Generating control-flow graph..." <<std::endl;
-        ControlFlowGraph cfg;
-        cfg.create_basic_blocks(s.m_quads, s.m_tac_labels);
-        cfg.generate_graph(s.m_quads);
-
-        std::cout << "Optimizing IR..." << std::endl;
-        Optimizer opt;
-        opt.eliminate_dead_code(&cfg, s.m_tac_labels);
-        opt.collapse_cond_jumps(&s.m_quads, &s.m_tac_labels);
-        opt.fold_constants(&s.m_quads);
-        opt.merge_adjacent_store_fetch(&s.m_quads);
-        opt.simplify_algebraic_identities(&s.m_quads);
-
-
-        std::cout << "Generating x86 code..." << std::endl;
-        X86Generator gen;
-        gen.generate_asm(cfg, &s.m_quads, &s.m_tac_labels, &frames, f.substr(0, f.size() - 4) + ".asm");
-        asm_files.push_back(f.substr(0, f.size() - 4) + ".asm");
-
-        if (ems.has_errors()) {
-            ems.print();
-            return 1;
+    std::vector<ModuleResult> compiled(tmd_files.size());
+    pool.run(tmd_files.size(), [&](size_t i) {
+        if (tmd_files[i].ends_with(".tacb")) {
+            compile_tacb(tmd_files[i], &compiled[i], pool, cache);
+        } else {
+            compile_tmd(tmd_files[i], &compiled[i], pool, cache, dump_tacb);
         }
+    });
+    if (!report(compiled)) {
+        return 1;
     }
 
-    
+    for (const std::string& f: tmd_files) {
+        asm_files.push_back(f.substr(0, f.rfind('.')) + ".asm");
+    }
 
+    std::vector<ModuleResult> assembled(asm_files.size());
+    pool.run(asm_files.size(), [&](size_t i) {
+        assemble_asm(asm_files[i], &assembled[i], cache);
+    });
+    if (!report(assembled)) {
+        return 1;
+    }
     for (const std::string& f: asm_files) {
-        std::string out = f.substr(0, f.size() - 4) + ".obj";
-        obj_files.push_back(out);
-
-        std::cout << "Assembling " << f << " to ELF relocatable objects..." << std::endl;
-        Assembler a;
-        a.generate_obj(f, out);
-
-        if (ems.has_errors()) {
-            ems.print();
-            return 1;
-        }
+        obj_files.push_back(f.substr(0, f.size() - 4) + ".obj");
     }
 
     std::cout << "Linking ELF relocatable object(s) into ELF executable..." << std::endl;
-    Linker l;
+    ErrorMsgs ems;
+    Linker l(ems);
     l.link(obj_files, "out.exe");
    
     if (ems.has_errors()) {
@@ -0,0 +1,177 @@
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+
+#include "module_cache.hpp"
+#include "semant.hpp"
+#include "source_buffer.hpp"
+#include "utility.hpp"
+#include "error.hpp"
+
+ModuleCache modules;
+
+/*
+ * .tmi layout (host byte order):
+ *  "TMI1", u64 content hash, u32 symbol count,
+ *  then per symbol: u32 name length, name bytes, type
+ *  type: u16 dtype, u16 rtype, u32 parameter count, parameter types
+ */
+static constexpr char TMI_MAGIC[4] = {'T', 'M', 'I', '1'};
+
+template <typename T>
+static void put(std::string& out, T v) {
+    out.append((const char*)&v, sizeof(T));
+}
+
+template <typename T>
+static bool get(std::string_view& in, T* v) {
+    if (in.size() < sizeof(T)) return false;
+    memcpy(v, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+static void put_type(std::string& out, TypeId type) {
+    TypeInfo info = types.info(type);
+    put<uint16_t>(out, info.m_dtype);
+    put<uint16_t>(out, types.dtype(info.m_rtype));
+    put<uint32_t>(out, info.m_param_count);
+    for (uint32_t i = 0; i < info.m_param_count; i++) {
+        put_type(out, types.param(type, i));
+    }
+}
+
+static bool get_type(std::string_view& in, TypeId* type) {
+    uint16_t dtype, rtype;
+    uint32_t count;
+    if (!get(in, &dtype) || !get(in, &rtype) || !get(in, &count)) return false;
+    if (dtype >= T_TOKEN_COUNT || rtype >= T_TOKEN_COUNT || count > in.size()) return false;
+
+    std::vector<TypeId> ptypes;
+    for (uint32_t i = 0; i < count; i++) {
+        TypeId p;
+        if (!get_type(in, &p)) return false;
+        ptypes.push_back(p);
+    }
+    *type = types.intern((enum TokenType)dtype, types.primitive((enum TokenType)rtype), ptypes);
+    return true;
+}
+
+//symbol ids depend on interning order, so signatures are hashed in name order to stay stable across builds
+static uint64_t interface_hash(const Scope& globals) {
+    std::vector<std::pair<std::string_view, TypeId>> sigs;
+    for (const std::pair<const SymbolId, Symbol>& p: globals.m_symbols) {
+        sigs.push_back({interner.view(p.first), p.second.m_type});
+    }
+    std::sort(sigs.begin(), sigs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::string out;
+    for (const std::pair<std::string_view, TypeId>& sig: sigs) {
+        put<uint32_t>(out, sig.first.size());
+        out.append(sig.first);
+        put_type(out, sig.second);
+    }
+    return hash_bytes(out);
+}
+
+const ModuleInterface* ModuleCache::load(const std::string& path, ErrorMsgs& ems) {
+    SourceBuffer source;
+    if (!source.open(path)) {
+        ems.add_error(0, "Error: Could not open '%s'.", path.c_str());
+        return nullptr;
+    }
+    uint64_t hash = hash_bytes(source.view());
+
+    std::promise<const ModuleInterface*> extracted;
+    std::shared_future<const ModuleInterface*> ready;
+    bool extract = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unordered_map<std::string, Entry>::iterator it = m_modules.find(path);
+        if (it != m_modules.end() && it->second.m_hash == hash) {
+            ready = it->second.m_iface;
+        } else {
+            ready = extracted.get_future().share();
+            m_modules[path] = {hash, ready};
+            extract = true;
+        }
+    }
+
+    if (!extract) {
+        const ModuleInterface* iface = ready.get();
+        ems.add_errors(iface->m_ems);
+        return iface;
+    }
+
+    std::unique_ptr<ModuleInterface> iface = std::make_unique<ModuleInterface>();
+    iface->m_path = path;
+    iface->m_hash = hash;
+
+    std::string tmi_path = path.substr(0, path.size() - 4) + ".tmi";
+    if (!m_persist || !read_interface(tmi_path, iface.get())) {
+        Semant s(nullptr, iface->m_ems);
+        s.extract_global_declarations(path);
+        iface->m_globals = s.m_globals;
+        if (m_persist && !iface->m_ems.has_errors()) {
+            write_interface(tmi_path, *iface);
+        }
+    }
+
+    iface->m_interface_hash = interface_hash(iface->m_globals);
+    ems.add_errors(iface->m_ems);
+    const ModuleInterface* ret = iface.get();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_interfaces.push_back(std::move(iface));
+    }
+    extracted.set_value(ret);
+    return ret;
+}
+
+//fails on a missing, malformed or stale interface file so the caller falls back to parsing
+bool ModuleCache::read_interface(const std::string& tmi_path, ModuleInterface* iface) {
+    std::ifstream f(tmi_path, std::ios::in | std::ios::binary);
+    if (!f) return false;
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::string buf = ss.str();
+    std::string_view in(buf);
+
+    char magic[4];
+    uint64_t hash;
+    uint32_t count;
+    if (in.size() < sizeof(magic) || memcmp(in.data(), TMI_MAGIC, sizeof(magic)) != 0) return false;
+    in.remove_prefix(sizeof(magic));
+    if (!get(in, &hash) || hash != iface->m_hash || !get(in, &count)) return false;
+
+    Scope globals;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t len;
+        if (!get(in, &len) || len > in.size()) return false;
+        SymbolId name = interner.intern(in.substr(0, len));
+        in.remove_prefix(len);
+
+        TypeId type;
+        if (!get_type(in, &type)) return false;
+        globals.m_symbols.insert({name, Symbol(name, Interner::EMPTY, type, 0)});
+    }
+
+    iface->m_globals = globals;
+    return true;
+}
+
+void ModuleCache::write_interface(const std::string& tmi_path, const ModuleInterface& iface) {
+    std::string out(TMI_MAGIC, sizeof(TMI_MAGIC));
+    put<uint64_t>(out, iface.m_hash);
+    put<uint32_t>(out, iface.m_globals.m_symbols.size());
+    for (const std::pair<const SymbolId, Symbol>& p: iface.m_globals.m_symbols) {
+        std::string_view name = interner.view(p.first);
+        put<uint32_t>(out, name.size());
+        out.append(name);
+        put_type(out, p.second.m_type);
+    }
+
+    std::ofstream f(tmi_path, std::ios::out | std::ios::binary);
+    f.write(out.data(), out.size());
+}
@@ -0,0 +1,53 @@
+#ifndef MODULE_CACHE_HPP
+#define MODULE_CACHE_HPP
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <future>
+
+#include "symbol.hpp"
+#include "error.hpp"
+
+/*
+ * Exported function signatures of one imported module.
+ */
+struct ModuleInterface {
+    std::string m_path;
+    uint64_t m_hash;
+    uint64_t m_interface_hash; //hash of the exported signatures only - stays put when just function bodies change
+    Scope m_globals;
+    ErrorMsgs m_ems; //errors found while extracting the interface, reported again to every importer
+};
+
+/*
+ * Extracts each imported module's interface once per build, keyed by path and content hash.
+ * With persistence on, interfaces are also written next to the module as a .tmi file
+ * and reused by later builds as long as the module's contents are unchanged.
+ * Modules compiled in parallel share one cache. The lock only covers the map: the first thread to ask
+ * for a module extracts it while later ones wait on that module's future, so imports of other modules
+ * are never held up behind a parse.
+ */
+class ModuleCache {
+    public:
+        bool m_persist = false;
+    private:
+        struct Entry {
+            uint64_t m_hash;
+            std::shared_future<const ModuleInterface*> m_iface;
+        };
+        std::unordered_map<std::string, Entry> m_modules;
+        std::vector<std::unique_ptr<ModuleInterface>> m_interfaces; //owns every interface handed out, even ones whose module changed since
+        std::mutex m_mutex;
+    public:
+        const ModuleInterface* load(const std::string& path, ErrorMsgs& ems);
+    private:
+        bool read_interface(const std::string& tmi_path, ModuleInterface* iface);
+        void write_interface(const std::string& tmi_path, const ModuleInterface& iface);
+};
+
+extern ModuleCache modules;
+
+#endif //MODULE_CACHE_HPP
@@ -3,194 +3,798 @@
 #include "utility.hpp"
 #include <iostream>
 #include <stack>
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
 
-void Optimizer::fold_constants(std::vector<TacQuad>* quads) {
-    for (int i = 0; i < quads->size(); i++) {
-        TacQuad q = (*quads)[i];
-        if (q.m_opd1 == "" || q.m_opd2 == "") continue;
+//turns `t = a op b; x = t` into `x = a op b` when nothing reads t afterwards
+void Optimizer::merge_adjacent_store_fetch(TacFunction* fn) {
+    ControlFlowGraph cfg(*fn);
+    Liveness liveness(*fn, cfg);
 
+    for (BlockId b = 0; b < fn->m_blocks.size(); b++) {
+        BitVector live = liveness.m_out[b]; //variables live just after q2
+        InstrId i = fn->m_blocks[b].m_last;
+        while (i != INSTR_NONE) {
+            InstrId prev = fn->m_instrs[i].m_prev;
+            TacQuad* q2 = &fn->quad(i);
 
-        if (is_int(q.m_opd1) && is_int(q.m_opd2)) {
-            char* p1;
-            char* p2;
-            int left = (int)strtol(q.m_opd1.c_str(), &p1, 10);
-            int right = (int)strtol(q.m_opd2.c_str(), &p2, 10);
-            int result;
-            switch (q.m_op) {
+            if (prev != INSTR_NONE) {
+                TacQuad* q1 = &fn->quad(prev);
+                if (q2->m_op == TacT::Assign && q1->defines_target() && q1->target().m_kind == OpdKind::Var &&
+                    q2->opd1() == q1->target() && !live.test(liveness.m_vars.id(q1->m_values[TacQuad::TARGET]))) {
+                    q2->set_opd1(q1->opd1());
+                    q2->set_opd2(q1->opd2());
+                    q2->m_op = q1->m_op;
+                    fn->remove(b, prev);
+                    continue; //the merged quad may merge again with the one now ahead of it
+                }
+            }
+
+            liveness.transfer(*q2, &live);
+            i = prev;
+        }
+    }
+}
+
+void Optimizer::simplify_algebraic_identities(TacFunction* fn) {
+    for (TacBlock& b: fn->m_blocks) {
+        for (InstrId i = b.m_first; i != INSTR_NONE; i = fn->next(i)) {
+            TacQuad* q = &fn->quad(i);
+
+            switch (q->m_op) {
                 case TacT::Plus:
-                    result = left + right;
+                    if (q->opd1().is_imm(0)) {
+                        q->set_opd1(q->opd2());
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    } else if (q->opd2().is_imm(0)) {
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    }
                     break;
                 case TacT::Minus:
-                    result = left - right;
+                    if (q->opd1() == q->opd2()) {
+                        q->set_opd1(Operand::imm(0));
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    } else if(q->opd2().is_imm(0)) {
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    }
                     break;
                 case TacT::Star:
-                    result = left * right;
+                    if (q->opd1().is_imm(1)) {
+                        q->set_opd1(q->opd2());
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    } else if (q->opd2().is_imm(1)) {
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    } else if (q->opd1().is_imm(0) || q->opd2().is_imm(0)) {
+                        q->set_opd1(Operand::imm(0));
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    }
                     break;
                 case TacT::Slash:
-                    result = left / right;
-                    break;
-                case TacT::Less:
-                    result = left < right;
-                    break;
-                case TacT::EqualEqual:
-                    result = left == right;
+                    if (q->opd2().is_imm(1)) {
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    } else if (q->opd1() == q->opd2()) {
+                        q->set_opd1(Operand::imm(1));
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    }
                     break;
                 case TacT::And:
-                    result = left && right;
+                    if (q->opd1() == q->opd2()) {
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    }
                     break;
                 case TacT::Or:
-                    result = left || right;
+                    if (q->opd1() == q->opd2()) {
+                        q->set_opd2(Operand::none());
+                        q->m_op = TacT::Assign;
+                    }
                     break;
-                default:
-                    continue;
             }
-            (*quads)[i] = TacQuad(q.m_target, std::to_string(result), "", TacT::Assign);
         }
     }
 }
 
-void Optimizer::merge_adjacent_store_fetch(std::vector<TacQuad>* quads) {
-    for (int i = 0; i < quads->size() - 1; i++) {
-        TacQuad* q1 = &((*quads)[i]);
-        TacQuad* q2 = &((*quads)[i + 1]);
+void Optimizer::mark_reachable_blocks(ControlFlowGraph* cfg) {
+    std::stack<BlockId> greys;
+    if (!cfg->m_blocks.empty()) {
+        cfg->m_blocks[ControlFlowGraph::ENTRY].m_mark = BasicBlock::Color::Grey;
+        greys.push(ControlFlowGraph::ENTRY);
+    }
+
+    while (greys.size() > 0) {
+        BasicBlock* cur = &cfg->m_blocks[greys.top()];
+        greys.pop();
+        for (BlockId dst: cur->m_succs) {
+            if (cfg->m_blocks[dst].m_mark == BasicBlock::Color::Black) {
+                cfg->m_blocks[dst].m_mark = BasicBlock::Color::Grey;
+                greys.push(dst);
+            }
+        }
+        cur->m_mark = BasicBlock::Color::White;
+    }
+}
+
+//a function is live once a live block calls it, and a block is live once its function's entry reaches it
+void Optimizer::eliminate_dead_code(std::vector<TacFunction>* functions) {
+    CallGraph calls(*functions);
+    std::vector<ControlFlowGraph> cfgs;
+    for (const TacFunction& fn: *functions) {
+        cfgs.push_back(ControlFlowGraph(fn));
+    }
 
-        if (q2->m_op == TacT::Assign && q2->m_opd1 == q1->m_target) {
-            q2->m_opd1 = q1->m_opd1;
-            q2->m_opd2 = q1->m_opd2;
-            q2->m_op = q1->m_op;
-            q1->m_target = "";
-            q1->m_opd1 = "";
-            q1->m_opd2 = "";
-            q1->m_op = TacT::EmptyQuad;
+    std::vector<bool> live(functions->size(), false);
+    std::stack<uint32_t> work;
+    auto add_root = [&](uint32_t f) {
+        if (f != CallGraph::NONE && !live[f]) {
+            live[f] = true;
+            work.push(f);
         }
+    };
 
+    bool is_executable = calls.function_index(interner.intern("main")) != CallGraph::NONE;
+    if (is_executable) {
+        add_root(calls.function_index(interner.intern("_start")));
+    } else {
+        for (uint32_t f = 0; f < functions->size(); f++) {
+            std::string_view name = interner.view((*functions)[f].m_name);
+            if (name.empty() || name[0] != '_') {
+                add_root(f);
+            }
+        }
+    }
+
+    while (work.size() > 0) {
+        uint32_t f = work.top();
+        work.pop();
+        mark_reachable_blocks(&cfgs[f]);
+        for (const CallSite& c: calls.m_nodes[f].m_calls) {
+            if (cfgs[f].m_blocks[c.m_block].m_mark == BasicBlock::Color::White) {
+                add_root(c.m_callee);
+            }
+        }
     }
+
+    std::vector<TacFunction> kept;
+    for (uint32_t f = 0; f < functions->size(); f++) {
+        if (!live[f]) continue;
+
+        TacFunction& fn = (*functions)[f];
+        std::vector<bool> dead(fn.m_blocks.size());
+        for (BlockId b = 0; b < fn.m_blocks.size(); b++) {
+            dead[b] = cfgs[f].m_blocks[b].m_mark != BasicBlock::Color::White;
+        }
+        fn.remove_blocks(dead);
+        kept.push_back(std::move(fn));
+    }
+    *functions = std::move(kept);
 }
 
-void Optimizer::simplify_algebraic_identities(std::vector<TacQuad>* quads) {
-    for (int i = 0; i < quads->size() - 1; i++) {
-        TacQuad* q = &((*quads)[i]);
-
-        switch (q->m_op) {
-            case TacT::Plus:
-                if (q->m_opd1 == "0") {
-                    q->m_opd1 = q->m_opd2;
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                } else if (q->m_opd2 == "0") {
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                }
-                break;
-            case TacT::Minus:
-                if (q->m_opd1 == q->m_opd2) {
-                    q->m_opd1 == "0";
-                    q->m_opd2 == "";
-                    q->m_op = TacT::Assign;
-                } else if(q->m_opd2 == "0") {
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                }
-                break;
-            case TacT::Star:
-                if (q->m_opd1 == "1") {
-                    q->m_opd1 = q->m_opd2;
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                } else if (q->m_opd2 == "1") {
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                } else if (q->m_opd1 == "0" || q->m_opd2 == "0") {
-                    q->m_opd1 = "0";
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                }
-                break;
-            case TacT::Slash:
-                if (q->m_opd2 == "1") {
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                } else if (q->m_opd1 == q->m_opd2) {
-                    q->m_opd1 = "1";
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                }
-                break;
-            case TacT::And:
-                if (q->m_opd1 == q->m_opd2) {
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                }
-                break;
-            case TacT::Or:
-                if (q->m_opd1 == q->m_opd2) {
-                    q->m_opd2 = "";
-                    q->m_op = TacT::Assign;
-                }
-                break;
+void Optimizer::collapse_cond_jumps(TacFunction* fn) {
+    for (BlockId b = 0; b + 1 < fn->m_blocks.size(); b++) {
+        InstrId last = fn->m_blocks[b].m_last;
+        if (last == INSTR_NONE) continue;
+
+        //a jump to the block laid out next can fall through instead
+        TacQuad& q = fn->quad(last);
+        if (q.m_op == TacT::CondGoto && q.opd2() == Operand::label(fn->m_blocks[b + 1].m_label)) {
+            q.set_opd2(Operand::none());
+        } else if (q.m_op == TacT::Goto && q.opd2() == Operand::label(fn->m_blocks[b + 1].m_label)) {
+            fn->remove(b, last);
         }
     }
 }
 
-void Optimizer::mark_from_root_label(ControlFlowGraph* cfg, const std::string& label) {
-        std::stack<BasicBlock*> greys;
-        BasicBlock* main_block = cfg->get_block(label);
-        if (main_block) {
-            greys.push(main_block);
-        }
-
-        while (greys.size() > 0) {
-            BasicBlock* cur = greys.top();
-            greys.pop();
-            for (const BlockEdge& e: cfg->m_edges) {
-                if (e.m_from == cur->m_label) {
-                    BasicBlock* dst = cfg->get_block(e.m_to);
-                    //@note: dst may be nullptr if function is imported
-                    if (dst && dst->m_mark == BasicBlock::Color::Black) {
-                        dst->m_mark = BasicBlock::Color::Grey;
-                        greys.push(dst);
-                    }
+//what constant propagation knows about a value: nothing yet (Top), one constant, or that it varies (Bottom)
+struct Lattice {
+    enum Kind: uint8_t {
+        Top,
+        Const,
+        Bottom
+    };
+    Kind m_kind;
+    int32_t m_value;
+
+    bool is_const(int32_t value) const { return m_kind == Const && m_value == value; }
+    bool operator==(const Lattice& other) const {
+        return m_kind == other.m_kind && (m_kind != Const || m_value == other.m_value);
+    }
+};
+
+static constexpr Lattice TOP = {Lattice::Top, 0};
+static constexpr Lattice BOTTOM = {Lattice::Bottom, 0};
+
+static Lattice constant(int32_t value) {
+    return {Lattice::Const, value};
+}
+
+static Lattice meet(Lattice a, Lattice b) {
+    if (a.m_kind == Lattice::Top) return b;
+    if (b.m_kind == Lattice::Top) return a;
+    return a == b ? a : BOTTOM;
+}
+
+//evaluates op the way the generated x86 code does, wrapping on overflow; a division that would trap varies
+static Lattice fold(TacT op, Lattice a, Lattice b) {
+    if ((op == TacT::Star || op == TacT::And) && (a.is_const(0) || b.is_const(0))) return constant(0);
+    if (a.m_kind == Lattice::Bottom || b.m_kind == Lattice::Bottom) return BOTTOM;
+    if (a.m_kind == Lattice::Top || b.m_kind == Lattice::Top) return TOP;
+
+    uint32_t x = a.m_value;
+    uint32_t y = b.m_value;
+    switch (op) {
+        case TacT::Plus: return constant((int32_t)(x + y));
+        case TacT::Minus: return constant((int32_t)(x - y));
+        case TacT::Star: return constant((int32_t)(x * y));
+        case TacT::Slash:
+            if (b.m_value == 0 || (a.m_value == INT_MIN && b.m_value == -1)) return BOTTOM;
+            return constant(a.m_value / b.m_value);
+        case TacT::Less: return constant(a.m_value < b.m_value);
+        case TacT::EqualEqual: return constant(x == y);
+        case TacT::And: return constant((int32_t)(x & y));
+        case TacT::Or: return constant((int32_t)(x | y));
+        default: return BOTTOM;
+    }
+}
+
+/*
+ * Sparse conditional constant propagation (Wegman-Zadeck) over one function in SSA form.
+ * A block is only evaluated once an edge into it is found executable, and a phi only meets the
+ * arguments of executable edges, so constants flow past branches that are never taken.
+ * Afterwards constant uses become immediates, their definitions and phis go, CondGotos on
+ * constants become Gotos and blocks that never execute are removed.
+ */
+void Optimizer::propagate_constants(SSATransformer* ssa) {
+    TacFunction* fn = ssa->m_fn;
+    size_t n = fn->m_blocks.size();
+    size_t nv = ssa->m_versions.size();
+    if (n == 0) return;
+
+    //where each version is read: quads by InstrId, phis by their index in the block
+    struct Use {
+        BlockId m_block;
+        uint32_t m_index;
+        bool m_phi;
+    };
+    std::vector<std::vector<Use>> uses(nv);
+    std::vector<bool> defined(nv, false);
+    for (BlockId b = 0; b < n; b++) {
+        for (uint32_t k = 0; k < ssa->m_phis[b].size(); k++) {
+            const Phi& phi = ssa->m_phis[b][k];
+            defined[ssa->version_id(phi.m_target)] = true;
+            for (const Operand& arg: phi.m_args) {
+                if (arg.m_kind == OpdKind::Var) uses[ssa->version_id(arg.m_value)].push_back({b, k, true});
+            }
+        }
+        for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = fn->next(i)) {
+            const TacQuad& q = fn->quad(i);
+            if (q.defines_target() && q.target().m_kind == OpdKind::Var) {
+                defined[ssa->version_id(q.m_values[TacQuad::TARGET])] = true;
+            }
+            for_each_use(q, [&](SymbolId name) { uses[ssa->version_id(name)].push_back({b, i, false}); });
+        }
+    }
+
+    //a version nothing defines holds the value on entry: a parameter, or whatever the slot held
+    std::vector<Lattice> values(nv, TOP);
+    for (uint32_t x = 0; x < nv; x++) {
+        if (!defined[x]) values[x] = BOTTOM;
+    }
+    auto value_of = [&](Operand o) {
+        if (o.is_imm()) return constant(o.imm());
+        return o.m_kind == OpdKind::Var ? values[ssa->version_id(o.m_value)] : BOTTOM;
+    };
+
+    std::vector<bool> reached(n, false);
+    std::vector<std::vector<bool>> taken(n); //per block, whether the edge from each predecessor executes
+    for (BlockId b = 0; b < n; b++) {
+        taken[b].assign(ssa->m_cfg.m_blocks[b].m_preds.size(), false);
+    }
+    std::vector<std::pair<BlockId, BlockId>> edges; //edges found executable, yet to be followed
+    std::vector<uint32_t> changed; //versions whose value dropped, yet to be passed on to their uses
+
+    auto set_value = [&](SymbolId name, Lattice v) {
+        uint32_t x = ssa->version_id(name);
+        if (values[x] == v) return;
+        values[x] = v;
+        changed.push_back(x);
+    };
+    auto eval_phi = [&](BlockId b, uint32_t k) {
+        const Phi& phi = ssa->m_phis[b][k];
+        Lattice v = TOP;
+        for (size_t j = 0; j < phi.m_args.size(); j++) {
+            if (taken[b][j]) v = meet(v, value_of(phi.m_args[j]));
+        }
+        set_value(phi.m_target, v);
+    };
+    auto eval_quad = [&](BlockId b, InstrId i) {
+        const TacQuad& q = fn->quad(i);
+        if (q.m_op == TacT::CondGoto) {
+            Lattice cond = value_of(q.target());
+            if (cond.m_kind == Lattice::Bottom) {
+                for (BlockId s: ssa->m_cfg.m_blocks[b].m_succs) {
+                    edges.push_back({b, s});
                 }
+            } else if (cond.m_kind == Lattice::Const) {
+                Operand label = cond.m_value ? q.opd2() : q.opd1();
+                edges.push_back({b, label.is_none() ? b + 1 : fn->block_of(label.m_value)});
             }
-            cur->m_mark = BasicBlock::Color::White;
+            return;
         }
-}
+        if (!q.defines_target() || q.target().m_kind != OpdKind::Var) return;
 
-void Optimizer::eliminate_dead_code(ControlFlowGraph* cfg, const std::vector<std::string>& labels) {
-    
-    bool is_executable = nullptr != cfg->get_block("main"); 
+        Lattice v = BOTTOM;
+        if (q.m_op == TacT::Assign) {
+            v = value_of(q.opd1());
+        } else if (q.m_op != TacT::CallResult) {
+            v = fold(q.m_op, value_of(q.opd1()), value_of(q.opd2()));
+        }
+        set_value(q.m_values[TacQuad::TARGET], v);
+    };
 
-    if (is_executable) {
-        mark_from_root_label(cfg, "_start");
-    } else {
-        for (BasicBlock& b: cfg->m_blocks) {
-            if (labels[b.m_begin][0] != '_') {
-                mark_from_root_label(cfg, labels[b.m_begin]);
+    edges.push_back({BLOCK_NONE, ControlFlowGraph::ENTRY});
+    while (!edges.empty() || !changed.empty()) {
+        if (!edges.empty()) {
+            std::pair<BlockId, BlockId> e = edges.back();
+            edges.pop_back();
+            BlockId b = e.second;
+            if (e.first != BLOCK_NONE) {
+                size_t j = ssa->m_cfg.pred_index(b, e.first);
+                if (taken[b][j]) continue;
+                taken[b][j] = true;
+            }
+
+            //a block already reached only has its phis' new argument to take in
+            for (uint32_t k = 0; k < ssa->m_phis[b].size(); k++) {
+                eval_phi(b, k);
+            }
+            if (reached[b]) continue;
+            reached[b] = true;
+            for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = fn->next(i)) {
+                eval_quad(b, i);
             }
+            InstrId last = fn->m_blocks[b].m_last;
+            if (last == INSTR_NONE || fn->quad(last).m_op != TacT::CondGoto) {
+                for (BlockId s: ssa->m_cfg.m_blocks[b].m_succs) {
+                    edges.push_back({b, s});
+                }
+            }
+            continue;
         }
-    }
 
-    std::vector<BasicBlock> temp;
-    for (BasicBlock b: cfg->m_blocks) {
-        temp.push_back(b);
+        uint32_t x = changed.back();
+        changed.pop_back();
+        for (const Use& u: uses[x]) {
+            if (!reached[u.m_block]) continue;
+            if (u.m_phi) {
+                eval_phi(u.m_block, u.m_index);
+            } else {
+                eval_quad(u.m_block, u.m_index);
+            }
+        }
     }
 
-    cfg->m_blocks.clear();
-    for (BasicBlock b: temp) {
-        if (b.m_mark == BasicBlock::Color::White) {
-            cfg->m_blocks.push_back(b);
+    auto known = [&](Operand o) {
+        return o.m_kind == OpdKind::Var && values[ssa->version_id(o.m_value)].m_kind == Lattice::Const;
+    };
+    auto immediate = [&](Operand o) {
+        return known(o) ? Operand::imm(values[ssa->version_id(o.m_value)].m_value) : o;
+    };
+
+    bool edited = false;
+    for (BlockId b = 0; b < n; b++) {
+        if (!reached[b]) {
+            edited = true;
+            continue;
+        }
+
+        std::vector<Phi>& phis = ssa->m_phis[b];
+        phis.erase(std::remove_if(phis.begin(), phis.end(), [&](const Phi& phi) {
+            return known(Operand::var(phi.m_target));
+        }), phis.end());
+        for (Phi& phi: phis) {
+            for (Operand& arg: phi.m_args) {
+                arg = immediate(arg);
+            }
+        }
+
+        InstrId next;
+        for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = next) {
+            next = fn->next(i);
+            TacQuad& q = fn->quad(i);
+            if (q.defines_target() && known(q.target())) {
+                fn->remove(b, i);
+                continue;
+            }
+            for (int o = 0; o < 3; o++) {
+                if (o == TacQuad::TARGET && q.defines_target()) continue;
+                q.set_opd(o, immediate(q.opd(o)));
+            }
+            if (q.m_op == TacT::CondGoto && q.target().is_imm()) {
+                Operand label = q.target().imm() ? q.opd2() : q.opd1();
+                if (label.is_none()) label = Operand::label(fn->m_blocks[b + 1].m_label);
+                q = TacQuad(Operand::none(), Operand::none(), label, TacT::Goto);
+                edited = true;
+            }
         }
     }
+    if (!edited) return;
+
+    std::vector<bool> dead(n);
+    for (BlockId b = 0; b < n; b++) {
+        dead[b] = !reached[b];
+    }
+    ssa->remove_blocks(dead);
+}
+
+//a pure computation by operation and value-numbered operands; equal keys compute equal values
+struct ExprKey {
+    TacT m_op;
+    Operand m_left;
+    Operand m_right;
+
+    bool operator==(const ExprKey& other) const {
+        return m_op == other.m_op && m_left == other.m_left && m_right == other.m_right;
+    }
+};
+
+struct ExprKeyHash {
+    size_t operator()(const ExprKey& k) const {
+        uint64_t kinds = ((uint64_t)k.m_op << 16) | ((uint64_t)k.m_left.m_kind << 8) | (uint64_t)k.m_right.m_kind;
+        uint64_t values = ((uint64_t)k.m_left.m_value << 32) | k.m_right.m_value;
+        return std::hash<uint64_t>()(values ^ (kinds * 0x9e3779b97f4a7c15ull));
+    }
+};
+
+static bool is_commutative(TacT op) {
+    return op == TacT::Plus || op == TacT::Star || op == TacT::And || op == TacT::Or || op == TacT::EqualEqual;
+}
 
+static bool is_pure_binary(TacT op) {
+    switch (op) {
+        case TacT::Plus:
+        case TacT::Minus:
+        case TacT::Star:
+        case TacT::Slash:
+        case TacT::Less:
+        case TacT::EqualEqual:
+        case TacT::And:
+        case TacT::Or:
+            return true;
+        default:
+            return false;
+    }
 }
 
-void Optimizer::collapse_cond_jumps(std::vector<TacQuad>* quads, std::vector<std::string>* labels) {
-    for (int i = 0; i < quads->size() - 1; i++) {
-        TacQuad& q = (*quads)[i];
-        if (q.m_op == TacT::CondGoto && q.m_opd2 == (*labels)[i + 1]) {
-            q.m_opd2 = ""; 
+/*
+ * Dominator-based global value numbering over one function in SSA form.
+ * Walking the dominator tree, each pure computation is looked up by its operation and the value
+ * numbers of its operands (ordered, for commutative operations); one already computed in a
+ * dominating block makes it redundant, so it is removed and its uses read the earlier result.
+ * A phi whose arguments are all one operand is replaced by it the same way. Copies, and phis
+ * whose arguments merely share a value number, stay in place but take their source's number,
+ * since removing them would leave copies between different variables for destruct() to insert.
+ * Only the table entries of the current block's dominators are visible, so a value is never
+ * reused on a path that doesn't compute it.
+ */
+void Optimizer::eliminate_common_subexpressions(SSATransformer* ssa) {
+    TacFunction* fn = ssa->m_fn;
+    std::vector<Operand> replaced(ssa->m_versions.size(), Operand::none()); //by the operand now read instead
+    std::vector<Operand> copies(ssa->m_versions.size(), Operand::none()); //by the operand whose value they copy
+    auto replacement = [&](Operand o) {
+        while (o.m_kind == OpdKind::Var) {
+            uint32_t x = ssa->version_id(o.m_value);
+            if (x == VarIndex::NONE || replaced[x].is_none()) break;
+            o = replaced[x];
+        }
+        return o;
+    };
+    auto number = [&](Operand o) {
+        while (o.m_kind == OpdKind::Var) {
+            uint32_t x = ssa->version_id(o.m_value);
+            if (x == VarIndex::NONE) break;
+            if (!replaced[x].is_none()) {
+                o = replaced[x];
+            } else if (!copies[x].is_none()) {
+                o = copies[x];
+            } else {
+                break;
+            }
+        }
+        return o;
+    };
+    auto replace_uses = [&](TacQuad* q) {
+        for (int o = 0; o < 3; o++) {
+            if (o == TacQuad::TARGET && q->defines_target()) continue;
+            q->set_opd(o, replacement(q->opd(o)));
+        }
+    };
+    //the one operand all of a phi's arguments (other than itself) come down to, or none
+    auto common_arg = [](const Phi& phi, auto map) {
+        Operand same = Operand::none();
+        for (const Operand& arg: phi.m_args) {
+            Operand v = map(arg);
+            if (v == Operand::var(phi.m_target) || v == same) continue;
+            if (!same.is_none()) return Operand::none();
+            same = v;
+        }
+        return same;
+    };
+
+    std::unordered_map<ExprKey, SymbolId, ExprKeyHash> available;
+    std::vector<ExprKey> scope; //keys added, removed again when the walk leaves the block that added them
+    std::vector<size_t> marks(fn->m_blocks.size());
+    ssa->m_dom.walk([&](BlockId b) {
+        marks[b] = scope.size();
+
+        std::vector<Phi>& phis = ssa->m_phis[b];
+        phis.erase(std::remove_if(phis.begin(), phis.end(), [&](Phi& phi) {
+            for (Operand& arg: phi.m_args) {
+                arg = replacement(arg);
+            }
+            uint32_t x = ssa->version_id(phi.m_target);
+            replaced[x] = common_arg(phi, [](Operand o) { return o; });
+            if (replaced[x].is_none()) copies[x] = common_arg(phi, number);
+            return !replaced[x].is_none();
+        }), phis.end());
+
+        InstrId next;
+        for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = next) {
+            next = fn->next(i);
+            TacQuad& q = fn->quad(i);
+            replace_uses(&q);
+            if (!q.defines_target() || q.target().m_kind != OpdKind::Var) continue;
+
+            uint32_t x = ssa->version_id(q.m_values[TacQuad::TARGET]);
+            if (q.m_op == TacT::Assign) {
+                copies[x] = number(q.opd1());
+                continue;
+            }
+            if (!is_pure_binary(q.m_op)) continue;
+
+            ExprKey key = {q.m_op, number(q.opd1()), number(q.opd2())};
+            if (is_commutative(key.m_op) && (key.m_left.m_kind > key.m_right.m_kind ||
+                (key.m_left.m_kind == key.m_right.m_kind && key.m_left.m_value > key.m_right.m_value))) {
+                std::swap(key.m_left, key.m_right);
+            }
+            std::unordered_map<ExprKey, SymbolId, ExprKeyHash>::iterator it = available.find(key);
+            if (it != available.end()) {
+                replaced[x] = Operand::var(it->second);
+                fn->remove(b, i);
+                continue;
+            }
+            available.insert({key, q.m_values[TacQuad::TARGET]});
+            scope.push_back(key);
+        }
+    }, [&](BlockId b) {
+        while (scope.size() > marks[b]) {
+            available.erase(scope.back());
+            scope.pop_back();
+        }
+    });
+
+    //phi arguments on back edges, and anything the walk didn't reach, may read values found redundant later
+    for (BlockId b = 0; b < fn->m_blocks.size(); b++) {
+        for (Phi& phi: ssa->m_phis[b]) {
+            for (Operand& arg: phi.m_args) {
+                arg = replacement(arg);
+            }
+        }
+        for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = fn->next(i)) {
+            replace_uses(&fn->quad(i));
         }
     }
 }
 
+/*
+ * Loop-invariant code motion over one function in SSA form.
+ * Every loop is first given a preheader. Then, innermost loops first, each pure computation whose
+ * operands are all defined outside the loop, or by computations already moved, goes to the end of
+ * the preheader and runs once instead of on every iteration. In SSA form the moved definition still
+ * dominates all its uses and nothing else writes its target, so moving it is always safe, provided
+ * it can't fault: divisions only move when dividing by a constant other than 0 and -1, since the
+ * loop may never have reached them. Copies stay, as moving them saves nothing.
+ */
+void Optimizer::hoist_loop_invariants(SSATransformer* ssa) {
+    TacFunction* fn = ssa->m_fn;
+    //inserting a preheader renumbers blocks, so the loops are found again after each one
+    for (bool inserted = true; inserted;) {
+        inserted = false;
+        for (const Loop& loop: ssa->m_cfg.natural_loops(ssa->m_dom)) {
+            if (loop.m_header == ControlFlowGraph::ENTRY || ssa->m_cfg.preheader(loop) != BLOCK_NONE) continue;
+            ssa->insert_preheader(loop);
+            inserted = true;
+            break;
+        }
+    }
+
+    std::vector<bool> in_loop(fn->m_blocks.size());
+    std::vector<bool> varying(ssa->m_versions.size()); //defined inside the current loop
+    for (const Loop& loop: ssa->m_cfg.natural_loops(ssa->m_dom)) {
+        BlockId pre = ssa->m_cfg.preheader(loop);
+        if (pre == BLOCK_NONE) continue;
+
+        for (BlockId b: loop.m_blocks) {
+            in_loop[b] = true;
+            for (const Phi& phi: ssa->m_phis[b]) {
+                varying[ssa->version_id(phi.m_target)] = true;
+            }
+            for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = fn->next(i)) {
+                const TacQuad& q = fn->quad(i);
+                if (q.defines_target() && q.target().m_kind == OpdKind::Var) varying[ssa->version_id(q.m_values[TacQuad::TARGET])] = true;
+            }
+        }
+
+        InstrId last = fn->m_blocks[pre].m_last;
+        InstrId pos = last != INSTR_NONE && (fn->quad(last).m_op == TacT::Goto || fn->quad(last).m_op == TacT::CondGoto) ? last : INSTR_NONE;
+        //in reverse postorder a definition in the loop comes before the uses it dominates
+        for (BlockId b: ssa->m_dom.order()) {
+            if (!in_loop[b]) continue;
+            InstrId next;
+            for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = next) {
+                next = fn->next(i);
+                TacQuad q = fn->quad(i);
+                if (!is_pure_binary(q.m_op) || q.target().m_kind != OpdKind::Var) continue;
+                if (q.m_op == TacT::Slash && (!q.opd2().is_imm() || q.opd2().imm() == 0 || q.opd2().imm() == -1)) continue;
+                bool invariant = true;
+                for_each_use(q, [&](SymbolId name) {
+                    uint32_t x = ssa->version_id(name);
+                    if (x != VarIndex::NONE && varying[x]) invariant = false;
+                });
+                if (!invariant) continue;
+
+                fn->remove(b, i);
+                fn->insert_before(pre, pos, q);
+                varying[ssa->version_id(q.m_values[TacQuad::TARGET])] = false;
+            }
+        }
 
+        for (BlockId b: loop.m_blocks) {
+            in_loop[b] = false;
+        }
+        varying.assign(varying.size(), false);
+    }
+}
+
+/*
+ * Induction-variable strength reduction over one function in SSA form.
+ * A basic induction variable i is a phi in the header of a loop with one latch, which the latch
+ * feeds i + c or i - c for a constant c. A product t = i * k by a constant k in the loop becomes an
+ * induction variable itself: a new phi of t's variable starts at i0 * k in the preheader and steps
+ * by c * k right after i does, so the multiply turns into an add. Both sides wrap alike on overflow.
+ * Products of one induction variable and one constant share a single new phi.
+ */
+void Optimizer::reduce_induction_variables(SSATransformer* ssa) {
+    TacFunction* fn = ssa->m_fn;
+    size_t nv = ssa->m_versions.size();
+    std::vector<BlockId> def_blocks(nv, BLOCK_NONE);
+    std::vector<InstrId> defs(nv, INSTR_NONE);
+    for (BlockId b = 0; b < fn->m_blocks.size(); b++) {
+        for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = fn->next(i)) {
+            const TacQuad& q = fn->quad(i);
+            if (!q.defines_target() || q.target().m_kind != OpdKind::Var) continue;
+            uint32_t x = ssa->version_id(q.m_values[TacQuad::TARGET]);
+            def_blocks[x] = b;
+            defs[x] = i;
+        }
+    }
+
+    struct Induction {
+        Operand m_start;
+        InstrId m_step; //the quad computing the next value
+        int32_t m_by;
+    };
+    std::vector<Operand> replaced(nv, Operand::none());
+    std::vector<bool> in_loop(fn->m_blocks.size(), false);
+    for (const Loop& loop: ssa->m_cfg.natural_loops(ssa->m_dom)) {
+        BlockId pre = ssa->m_cfg.preheader(loop);
+        if (pre == BLOCK_NONE || loop.m_latches.size() != 1) continue;
+        size_t from_pre = ssa->m_cfg.pred_index(loop.m_header, pre);
+        size_t from_latch = ssa->m_cfg.pred_index(loop.m_header, loop.m_latches[0]);
+        for (BlockId b: loop.m_blocks) {
+            in_loop[b] = true;
+        }
+
+        std::unordered_map<uint32_t, Induction> basic; //by the phi's version
+        for (const Phi& phi: ssa->m_phis[loop.m_header]) {
+            //the next value usually reaches the phi through a copy out of a temporary
+            Operand next = phi.m_args[from_latch];
+            uint32_t x = VarIndex::NONE;
+            for (int hops = 0; hops < 2 && next.m_kind == OpdKind::Var; hops++) {
+                x = ssa->version_id(next.m_value);
+                if (x == VarIndex::NONE || defs[x] == INSTR_NONE || fn->quad(defs[x]).m_op != TacT::Assign) break;
+                next = fn->quad(defs[x]).opd1();
+            }
+            if (x == VarIndex::NONE || defs[x] == INSTR_NONE || !in_loop[def_blocks[x]]) continue;
+            const TacQuad& q = fn->quad(defs[x]);
+            Operand self = Operand::var(phi.m_target);
+            if (q.m_op == TacT::Plus && q.opd1() == self && q.opd2().is_imm()) {
+                basic.insert({ssa->version_id(phi.m_target), {phi.m_args[from_pre], defs[x], q.opd2().imm()}});
+            } else if (q.m_op == TacT::Plus && q.opd2() == self && q.opd1().is_imm()) {
+                basic.insert({ssa->version_id(phi.m_target), {phi.m_args[from_pre], defs[x], q.opd1().imm()}});
+            } else if (q.m_op == TacT::Minus && q.opd1() == self && q.opd2().is_imm()) {
+                basic.insert({ssa->version_id(phi.m_target), {phi.m_args[from_pre], defs[x], (int32_t)(0u - (uint32_t)q.opd2().imm())}});
+            }
+        }
+
+        std::unordered_map<uint64_t, SymbolId> reduced; //by induction variable and factor
+        if (!basic.empty()) {
+            for (BlockId b: loop.m_blocks) {
+                InstrId next;
+                for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = next) {
+                    next = fn->next(i);
+                    const TacQuad& q = fn->quad(i);
+                    if (q.m_op != TacT::Star || q.target().m_kind != OpdKind::Var) continue;
+                    Operand iv = q.opd2().is_imm() ? q.opd1() : q.opd1().is_imm() ? q.opd2() : Operand::none();
+                    if (iv.m_kind != OpdKind::Var) continue;
+                    std::unordered_map<uint32_t, Induction>::const_iterator it = basic.find(ssa->version_id(iv.m_value));
+                    int32_t k = q.opd2().is_imm() ? q.opd2().imm() : q.opd1().imm();
+                    if (it == basic.end() || k == 0 || k == 1) continue;
+
+                    uint32_t x = ssa->version_id(q.m_values[TacQuad::TARGET]);
+                    uint64_t key = (uint64_t)it->first << 32 | (uint32_t)k;
+                    std::unordered_map<uint64_t, SymbolId>::iterator done = reduced.find(key);
+                    if (done == reduced.end()) {
+                        const Induction& ind = it->second;
+                        uint32_t var = ssa->m_versions[x].m_var;
+                        SymbolId current = ssa->new_version(var);
+                        SymbolId stepped = ssa->new_version(var);
+
+                        Operand start;
+                        if (ind.m_start.is_imm()) {
+                            start = Operand::imm((int32_t)((uint32_t)ind.m_start.imm() * (uint32_t)k));
+                        } else {
+                            start = Operand::var(ssa->new_version(var));
+                            InstrId last = fn->m_blocks[pre].m_last;
+                            InstrId pos = last != INSTR_NONE && (fn->quad(last).m_op == TacT::Goto || fn->quad(last).m_op == TacT::CondGoto) ? last : INSTR_NONE;
+                            fn->insert_before(pre, pos, TacQuad(start, ind.m_start, Operand::imm(k), TacT::Star));
+                        }
+                        Operand by = Operand::imm((int32_t)((uint32_t)ind.m_by * (uint32_t)k));
+                        BlockId step_block = def_blocks[ssa->version_id(fn->quad(ind.m_step).m_values[TacQuad::TARGET])];
+                        fn->insert_before(step_block, fn->next(ind.m_step), TacQuad(Operand::var(stepped), Operand::var(current), by, TacT::Plus));
+
+                        std::vector<Operand> args(ssa->m_cfg.m_blocks[loop.m_header].m_preds.size());
+                        args[from_pre] = start;
+                        args[from_latch] = Operand::var(stepped);
+                        ssa->m_phis[loop.m_header].push_back({current, var, std::move(args)});
+                        done = reduced.insert({key, current}).first;
+                    }
+                    replaced[x] = Operand::var(done->second);
+                    fn->remove(b, i);
+                }
+            }
+        }
+
+        for (BlockId b: loop.m_blocks) {
+            in_loop[b] = false;
+        }
+    }
+
+    auto replacement = [&](Operand o) {
+        uint32_t x = o.m_kind == OpdKind::Var ? ssa->version_id(o.m_value) : VarIndex::NONE;
+        return x < nv && !replaced[x].is_none() ? replaced[x] : o;
+    };
+    for (BlockId b = 0; b < fn->m_blocks.size(); b++) {
+        for (Phi& phi: ssa->m_phis[b]) {
+            for (Operand& arg: phi.m_args) {
+                arg = replacement(arg);
+            }
+        }
+        for (InstrId i = fn->m_blocks[b].m_first; i != INSTR_NONE; i = fn->next(i)) {
+            TacQuad& q = fn->quad(i);
+            for (int o = 0; o < 3; o++) {
+                if (o == TacQuad::TARGET && q.defines_target()) continue;
+                q.set_opd(o, replacement(q.opd(o)));
+            }
+        }
+    }
+}
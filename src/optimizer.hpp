@@ -4,15 +4,26 @@
 #include <vector>
 #include "tac.hpp"
 #include "ControlFlowGraph.hpp"
+#include "call_graph.hpp"
+#include "dataflow.hpp"
+#include "ssa.hpp"
 
+/*
+ * Dead code elimination works on the whole module: its call graph and each function's control-flow graph.
+ * The quad passes only touch one TacFunction, and the SSA passes one function in SSA form,
+ * so functions can be optimized on separate threads.
+ */
 class Optimizer {
     public:
-        void fold_constants(std::vector<TacQuad>* quads);
-        void merge_adjacent_store_fetch(std::vector<TacQuad>* quads);
-        void simplify_algebraic_identities(std::vector<TacQuad>* quads);
-        void collapse_cond_jumps(std::vector<TacQuad>* quads, std::vector<std::string>* labels);
-        void mark_from_root_label(ControlFlowGraph* cfg, const std::string& label);
-        void eliminate_dead_code(ControlFlowGraph* cfg, const std::vector<std::string>& labels);
+        void merge_adjacent_store_fetch(TacFunction* fn);
+        void simplify_algebraic_identities(TacFunction* fn);
+        void collapse_cond_jumps(TacFunction* fn);
+        void propagate_constants(SSATransformer* ssa);
+        void eliminate_common_subexpressions(SSATransformer* ssa);
+        void hoist_loop_invariants(SSATransformer* ssa);
+        void reduce_induction_variables(SSATransformer* ssa);
+        void mark_reachable_blocks(ControlFlowGraph* cfg);
+        void eliminate_dead_code(std::vector<TacFunction>* functions);
 };
 
 
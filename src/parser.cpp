@@ -1,37 +1,33 @@
 #include "parser.hpp"
 #include "error.hpp"
 
+void Parser::init(SourceBuffer& source, const KeywordTable& reserved_words, AstTree& tree, ErrorMsgs& ems) {
+    m_source = &source;
+    m_ems = &ems;
+    m_tree = &tree;
+    m_tokens.init(source, reserved_words, ems);
+}
+
 struct Token Parser::peek_one() {
-    int next = m_current;
-    if (next >= m_tokens.size())
-        next = m_tokens.size() - 1;
-    return m_tokens[next];
+    return m_tokens.peek_one();
 }
 
 struct Token Parser::peek_two() {
-    int next = m_current + 1;
-    if (next >= m_tokens.size())
-        next = m_tokens.size() - 1;
-    return m_tokens[next];
+    return m_tokens.peek_two();
 }
 
 struct Token Parser::next_token() {
-    int next = m_current;
-    if (next >= m_tokens.size())
-        next = m_tokens.size() - 1;
-    struct Token ret = m_tokens[next];
-    m_current++;
-    return ret;
+    return m_tokens.next_token();
 }
 
 struct Token Parser::consume_token(enum TokenType tt) {
-    struct Token t = next_token();
-    if (t.type != tt) {
-        ems.add_error(t.line, "Unexpected token!");
-    }
-    return t;
+    return m_tokens.consume_token(tt);
 }
 
 bool Parser::end_of_tokens() {
-    return peek_one().type == T_EOF;
+    return m_tokens.end_of_tokens();
+}
+
+SymbolId Parser::intern(struct Token t) {
+    return interner.intern(m_source->text(t));
 }
@@ -4,21 +4,26 @@
 #include <vector>
 #include "ast.hpp"
 #include "token.hpp"
+#include "token_stream.hpp"
 
 class Parser {
     public:
-        std::vector<struct Token> m_tokens;
-        int m_current;
-        std::vector<Ast*> m_nodes;
+        TokenStream m_tokens;
+        const SourceBuffer* m_source;
+        AstTree* m_tree;
+        ErrorMsgs* m_ems;
+        std::vector<AstId> m_nodes;
 
     public:
-        virtual std::vector<Ast*> parse_tokens(const std::vector<struct Token>& tokens) = 0;
+        void init(SourceBuffer& source, const KeywordTable& reserved_words, AstTree& tree, ErrorMsgs& ems);
+        virtual std::vector<AstId> parse_tokens() = 0;
     protected:
         struct Token peek_two();
         struct Token peek_one();
         struct Token next_token();
         struct Token consume_token(enum TokenType tt);
         bool end_of_tokens();
+        SymbolId intern(struct Token t);
 };
 
 
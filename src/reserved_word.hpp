@@ -1,11 +1,74 @@
 #ifndef RESERVED_WORD_NEW_HPP
 #define RESERVED_WORD_NEW_HPP
 
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <string_view>
+
 #include "token.hpp"
 
 struct ReservedWordNew {
-    std::string m_string;
-    enum TokenType m_token_type;
+    std::string_view m_string;
+    enum TokenType m_token_type = T_IDENTIFIER;
+};
+
+/*
+ * Perfect hash over a fixed set of reserved words.
+ * The seed is searched for at compile time so that every word lands in its own slot,
+ * so a lookup is a single hash, one length check and one memcmp.
+ */
+class KeywordTable {
+    public:
+        static constexpr uint32_t SLOT_COUNT = 256;
+        static constexpr uint32_t MAX_SEED = 1 << 16;
+    public:
+        std::array<ReservedWordNew, SLOT_COUNT> m_slots {};
+        uint32_t m_seed = 0;
+    public:
+        template <size_t N>
+        consteval KeywordTable(const ReservedWordNew (&words)[N]) {
+            static_assert(N < SLOT_COUNT / 2, "KeywordTable: too many reserved words for slot count");
+
+            for (uint32_t seed = 0; seed < MAX_SEED; seed++) {
+                std::array<bool, SLOT_COUNT> used {};
+                bool collision = false;
+                for (size_t i = 0; i < N && !collision; i++) {
+                    uint32_t s = slot(words[i].m_string.data(), words[i].m_string.size(), seed);
+                    collision = used[s];
+                    used[s] = true;
+                }
+
+                if (!collision) {
+                    m_seed = seed;
+                    for (size_t i = 0; i < N; i++) {
+                        m_slots[slot(words[i].m_string.data(), words[i].m_string.size(), seed)] = words[i];
+                    }
+                    return;
+                }
+            }
+
+            throw "KeywordTable: no perfect hash seed found";
+        }
+
+        enum TokenType find(const char* s, int len) const {
+            const ReservedWordNew& rw = m_slots[slot(s, len, m_seed)];
+            if (int(rw.m_string.size()) == len && memcmp(rw.m_string.data(), s, len) == 0) {
+                return rw.m_token_type;
+            }
+            return T_IDENTIFIER;
+        }
+
+    private:
+        //FNV-1a with the seed folded into the offset basis
+        static constexpr uint32_t slot(const char* s, size_t len, uint32_t seed) {
+            uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+            for (size_t i = 0; i < len; i++) {
+                h ^= (uint8_t)s[i];
+                h *= 16777619u;
+            }
+            return (h ^ (h >> 16)) & (SLOT_COUNT - 1);
+        }
 };
 
 
@@ -1,99 +1,74 @@
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <algorithm>
 
 #include "semant.hpp"
-#include "tmdAst.hpp"
 #include "error.hpp"
 
 
-void Semant::add_tac_label(const std::string& label) {
-    m_tac_labels.resize(m_quads.size(), "");
-    m_tac_labels.push_back(label);
+void Semant::begin_function(SymbolId name) {
+    m_functions.push_back(TacFunction(name));
+    add_tac_label(name);
 }
 
-
-X86Frame* Semant::get_compiling_frame() {
-    AstFunDef *f = dynamic_cast<AstFunDef*>(m_compiling_fun);
-    std::string fun_name = std::string(f->m_symbol.start, f->m_symbol.len);
-    std::unordered_map<std::string, X86Frame>::iterator it = m_frames->find(fun_name);
-    return &(it->second);
+void Semant::add_tac_label(SymbolId label) {
+    m_block = m_functions.back().add_block(label);
+    m_after_return = false;
 }
 
-void Semant::insert_return_labels() {
-    for (int i = 0; i < m_quads.size() - 1; i++) {
-        const TacQuad& q1 = m_quads[i];
-        const TacQuad& q2 = m_quads[i + 1];
-        if (q1.m_opd1 == "return" && q2.m_opd1 != "end_fun" && m_tac_labels[i + 1] == "") {
-            m_tac_labels[i + 1] = TacQuad::new_label();
-        }
+InstrId Semant::emit(const TacQuad& q) {
+    //code after a return gets its own block, so dead code elimination can drop it
+    if (m_after_return && q.m_op != TacT::FunEnd) {
+        add_tac_label(new_label());
     }
+    m_after_return = q.m_op == TacT::Return;
+    return m_functions.back().append(m_block, q);
+}
+
+
+X86Frame* Semant::get_compiling_frame() {
+    std::unordered_map<SymbolId, X86Frame>::iterator it = m_frames->find(m_tree[m_compiling_fun].m_sym);
+    return &(it->second);
 }
 
-void Semant::generate_ir(const std::string& input_file, const std::string& output_file) {
+void Semant::generate_ir(const std::string& input_file) {
     read(input_file);
     lex();
-    if (ems.has_errors()) return;
+    if (m_ems.has_errors()) return;
     parse();
-    if (ems.has_errors()) return;
+    if (m_ems.has_errors()) return;
 
-    add_tac_label("_start");
-    m_quads.push_back(TacQuad("", "entry", "", TacT::Entry));
-    m_quads.push_back(TacQuad("", "call", "main", TacT::CallNil));
-    m_quads.push_back(TacQuad("", "exit", "", TacT::Exit));
+    begin_function(interner.intern("_start"));
+    emit(TacQuad(Operand::none(), Operand::none(), Operand::none(), TacT::Entry));
+    emit(TacQuad(Operand::none(), Operand::none(), Operand::fun(interner.intern("main")), TacT::CallNil));
+    emit(TacQuad(Operand::none(), Operand::none(), Operand::none(), TacT::Exit));
 
     translate_to_ir();
-
-    m_tac_labels.resize(m_quads.size(), "");
-
-    insert_return_labels();
-
-    /*
-    for (int i = 0; i < m_quads.size(); i++) {
-        const TacQuad& q = m_quads[i];
-        const std::string& s = m_tac_labels[i];
-        if (s != "") {
-            write_ir("%s:", s.c_str());
-        }
-        write_ir("    %s", q.to_string().c_str()); 
-    }
-
-    std::ofstream f(output_file, std::ios::out | std::ios::binary);
-    f.write((const char*)m_irbuf.data(), m_irbuf.size());*/
 }
 
 void Semant::read(const std::string& input_file) {
-    std::ifstream f(input_file);
-    std::stringstream buffer;
-    buffer << f.rdbuf();
-    m_code = buffer.str();
+    if (!m_source.open(input_file)) {
+        m_ems.add_error(0, "Error: Could not open '%s'.", input_file.c_str());
+    }
 }
 
+//tokens are lexed on demand while parsing, so this only sets up the token stream
 void Semant::lex() {
-    m_tokens = m_lexer.lex(m_code, m_reserved_words);
+    m_parser.init(m_source, m_reserved_words, m_tree, m_ems);
 }
 
 void Semant::parse() {
-    m_nodes = m_parser.parse_tokens(m_tokens);
+    m_nodes = m_parser.parse_tokens();
 }
 
 void Semant::translate_to_ir() {
-    for (Ast* n: m_nodes) {
-        n->emit_ir(*this);
+    for (AstId id: m_nodes) {
+        emit_ir(id);
     }
 }
 
-void Semant::write_ir(const char* format, ...) {
-    va_list ap;
-    va_start(ap, format);
-    char s[256];
-    int n = vsprintf(s, format, ap);
-    va_end(ap);
-    s[n] = '\n';
-    s[n + 1] = '\0';
-    std::string str(s);
-    m_irbuf.insert(m_irbuf.end(), (uint8_t*)str.data(), (uint8_t*)str.data() + str.size());
+SymbolId Semant::new_label() {
+    return interner.intern("_L" + std::to_string(generate_label_id()));
 }
 
 int Semant::generate_label_id() {
@@ -111,199 +86,117 @@ void Semant::write(const std::string& output_file) {
  * Tamarind Parser
  */
 
-Ast* Semant::TmdParser::parse_group() {
+AstId Semant::TmdParser::parse_group() {
     consume_token(T_L_PAREN);
-    Ast* n = parse_expr();
+    AstId n = parse_expr();
     consume_token(T_R_PAREN);
     return n;
 }
 
-Ast* Semant::TmdParser::parse_literal() {
+AstId Semant::TmdParser::parse_literal() {
     struct Token next = peek_one();
     if (next.type == T_L_PAREN) {
         return parse_group();
     } else if (next.type == T_IDENTIFIER && peek_two().type == T_L_PAREN) {
         struct Token sym = next_token();
         consume_token(T_L_PAREN);
-        std::vector<Ast*> params = std::vector<Ast*>();
+        std::vector<AstId> params = std::vector<AstId>();
         while (peek_one().type != T_R_PAREN) {
             params.push_back(parse_expr());
             if (peek_one().type == T_COMMA)
                consume_token(T_COMMA); 
         }
         consume_token(T_R_PAREN);
-        return new AstCall(sym, params);
+        return m_tree->add(AstKind::Call, sym, m_tree->add_list(params), params.size(), AST_NONE, 0, intern(sym));
     } else if (next.type == T_IDENTIFIER) {
-        return new AstGetSym(next_token());
+        struct Token sym = next_token();
+        return m_tree->add(AstKind::GetSym, sym, AST_NONE, AST_NONE, AST_NONE, 0, intern(sym));
     } else if (next.type == T_INT) {
-        return new AstLiteral(next_token());
+        return m_tree->add(AstKind::Literal, next_token());
     } else if (next.type == T_TRUE) {
-        return new AstLiteral(next_token());
+        return m_tree->add(AstKind::Literal, next_token());
     } else if (next.type == T_FALSE) {
-        return new AstLiteral(next_token());
+        return m_tree->add(AstKind::Literal, next_token());
     } else if (next.type == T_NIL) {
-        return new AstLiteral(next_token());
+        return m_tree->add(AstKind::Literal, next_token());
     } else {
-        ems.add_error(next.line, "Parse Error: Unexpected token.");
-        return new AstLiteral(next_token());
+        m_ems->add_error(m_source->line(next), "Parse Error: Unexpected token.");
+        return m_tree->add(AstKind::Literal, next_token());
     }
 }
 
-Ast* Semant::TmdParser::parse_unary() {
+AstId Semant::TmdParser::parse_unary() {
     struct Token next = peek_one();
     if (next.type == T_MINUS || next.type == T_NOT) {
         struct Token op = next_token();
-        return new AstUnary(op, parse_unary());
+        return m_tree->add(AstKind::Unary, op, parse_unary());
     } else {
         return parse_literal();
     }
 }
 
-Ast* Semant::TmdParser::parse_factor() {
-    Ast *left = parse_unary();
-
-    while (1) {
-        struct Token next = peek_one();
-        if (next.type != T_STAR && next.type != T_SLASH)
-            break;
-
-        struct Token op = next_token();
-        Ast *right = parse_unary();
-        left = new AstBinary(op, left, right);
-    }
-
-    return left;
-}
-
-Ast* Semant::TmdParser::parse_term() {
-    Ast *left = parse_factor();
-
-    while (1) {
-        struct Token next = peek_one();
-        if (next.type != T_MINUS && next.type != T_PLUS)
-            break;
-
-        struct Token op = next_token();
-        Ast *right = parse_factor();
-        left = new AstBinary(op, left, right);
-    }
-
-    return left;
-}
-
-Ast* Semant::TmdParser::parse_inequality() {
-    Ast *left = parse_term();
+//precedence climbing: all binary operators are left associative, so the right operand
+//only takes operators that bind tighter than the current one
+AstId Semant::TmdParser::parse_binary(uint8_t min_power) {
+    AstId left = parse_unary();
 
     while (1) {
-        struct Token next = peek_one();
-        if (next.type != T_LESS && next.type != T_LESS_EQUAL &&
-            next.type != T_GREATER && next.type != T_GREATER_EQUAL) {
+        uint8_t power = s_binding_power[peek_one().type];
+        if (power <= min_power)
             break;
-        }
 
         struct Token op = next_token();
-        Ast *right = parse_term();
-        left = new AstBinary(op, left, right);
+        AstId right = parse_binary(power);
+        left = m_tree->add(AstKind::Binary, op, left, right);
     }
 
     return left;
 }
 
-Ast* Semant::TmdParser::parse_equality() {
-    Ast *left = parse_inequality();
-
-    while (1) {
-        struct Token next = peek_one();
-        if (next.type != T_EQUAL_EQUAL && next.type != T_NOT_EQUAL) {
-            break;
-        }
-
-        struct Token op = next_token();
-        Ast *right = parse_inequality();
-        left = new AstBinary(op, left, right);
-    }
-
-    return left;
-}
-
-Ast* Semant::TmdParser::parse_and() {
-    Ast *left = parse_equality();
-
-    while (1) {
-        struct Token next = peek_one();
-        if (next.type != T_AND) {
-            break;
-        }
-
-        struct Token op = next_token();
-        Ast *right = parse_equality();
-        left = new AstBinary(op, left, right);
-    }
-
-    return left;
-}
-
-Ast* Semant::TmdParser::parse_or() {
-    Ast *left = parse_and();
-
-    while (1) {
-        struct Token next = peek_one();
-        if (next.type != T_OR) {
-            break;
-        }
-
-        struct Token op = next_token();
-        Ast *right = parse_and();
-        left = new AstBinary(op, left, right);
-    }
-
-    return left;
-}
-
-Ast* Semant::TmdParser::parse_assignment() {
+AstId Semant::TmdParser::parse_assignment() {
     if (peek_one().type == T_IDENTIFIER && peek_two().type == T_EQUAL) {
         struct Token var = consume_token(T_IDENTIFIER);
         consume_token(T_EQUAL);
-        Ast *expr = parse_expr();
-        return new AstSetSym(var, expr);
+        AstId expr = parse_expr();
+        return m_tree->add(AstKind::SetSym, var, expr, AST_NONE, AST_NONE, 0, intern(var));
     } else {
-        return parse_or();
+        return parse_binary(0);
     }
 }
 
-Ast* Semant::TmdParser::parse_expr() {
+AstId Semant::TmdParser::parse_expr() {
     return parse_assignment(); 
 }
 
-Ast* Semant::TmdParser::parse_block() {
-    consume_token(T_L_BRACE);
-    std::vector<Ast*> stmts;
+AstId Semant::TmdParser::parse_block() {
+    struct Token brace = consume_token(T_L_BRACE);
+    std::vector<AstId> stmts;
     while (peek_one().type != T_R_BRACE && peek_one().type != T_EOF) {
         stmts.push_back(parse_stmt());
     }
     consume_token(T_R_BRACE);
-    return new AstBlock(stmts);
+    return m_tree->add(AstKind::Block, brace, m_tree->add_list(stmts), stmts.size());
 }
 
 
-Ast* Semant::TmdParser::parse_stmt() {
+AstId Semant::TmdParser::parse_stmt() {
     struct Token next = peek_one();
     if (next.type == T_PRINT) {
-        next_token();
+        struct Token print = next_token();
         consume_token(T_L_PAREN);
-        Ast* arg = parse_expr();
+        AstId arg = parse_expr();
         consume_token(T_R_PAREN);
-        return new AstPrint(arg);
+        return m_tree->add(AstKind::Print, print, arg);
     } else if (next.type == T_IDENTIFIER && peek_two().type == T_COLON_COLON) {
         struct Token sym = consume_token(T_IDENTIFIER);
         consume_token(T_COLON_COLON);
         consume_token(T_L_PAREN);
-        std::vector<Ast*> params;
+        std::vector<AstId> params;
         while (peek_one().type != T_R_PAREN) {
             struct Token sym = consume_token(T_IDENTIFIER);
             consume_token(T_COLON);
             struct Token type = next_token();
-            params.push_back(new AstParam(sym, type));
+            params.push_back(m_tree->add(AstKind::Param, sym, AST_NONE, AST_NONE, AST_NONE, type.type, intern(sym)));
             if (peek_one().type == T_COMMA) {
                 consume_token(T_COMMA);
             }
@@ -315,67 +208,86 @@ Ast* Semant::TmdParser::parse_stmt() {
         struct Token ret_type = next_token();
         if (ret_type.type == T_NIL) ret_type.type = T_NIL_TYPE;
 
-        Ast* body = parse_block();
-        return new AstFunDef(sym, params, ret_type, body);
+        AstId body = parse_block();
+        return m_tree->add(AstKind::FunDef, sym, m_tree->add_list(params), params.size(), body, ret_type.type, intern(sym));
     } else if (next.type == T_IDENTIFIER && peek_two().type == T_COLON) {
         struct Token sym = consume_token(T_IDENTIFIER);
         consume_token(T_COLON);
         struct Token type = next_token();
         consume_token(T_EQUAL);
-        Ast *expr = parse_expr();
-        return new AstDeclSym(sym, type, expr);
+        AstId expr = parse_expr();
+        return m_tree->add(AstKind::DeclSym, sym, expr, AST_NONE, AST_NONE, type.type, intern(sym));
     } else if (next.type == T_L_BRACE) {
         return parse_block();
     } else if (next.type == T_IF) {
         struct Token if_token = next_token();
-        Ast* condition = parse_expr();
-        Ast* then_block = parse_block();
-        Ast* else_block = NULL;
+        AstId condition = parse_expr();
+        AstId then_block = parse_block();
+        AstId else_block = AST_NONE;
         if (peek_one().type == T_ELSE) {
             next_token();
             else_block = parse_block();
         }
-        return new AstIf(if_token, condition, then_block, else_block);
+        return m_tree->add(AstKind::If, if_token, condition, then_block, else_block);
     } else if (next.type == T_WHILE) {
         struct Token while_token = next_token();
-        Ast* condition = parse_expr();
-        Ast* while_block = parse_block();
-        return new AstWhile(while_token, condition, while_block);
+        AstId condition = parse_expr();
+        AstId while_block = parse_block();
+        return m_tree->add(AstKind::While, while_token, condition, while_block);
     } else if (next.type == T_IMPORT) {
         next_token();
         struct Token sym = consume_token(T_IDENTIFIER);
-        return new AstImport(sym);
+        return m_tree->add(AstKind::Import, sym);
     } else if (next.type == T_RETURN) {
         struct Token ret = next_token();
-        Ast* expr = parse_expr();
-        return new AstReturn(ret, expr);
+        AstId expr = parse_expr();
+        return m_tree->add(AstKind::Return, ret, expr);
     } else {
-        return new AstExprStmt(parse_expr());
+        return m_tree->add(AstKind::ExprStmt, next, parse_expr());
     }
 }
 
+//lexes just far enough to list the imported module files, without parsing or checking anything
+std::vector<std::string> Semant::find_imports(SourceBuffer& source) {
+    std::vector<std::string> imports;
+    ErrorMsgs ems; //the real compile reports any errors
+    Lexer l;
+    l.init(source, m_reserved_words, ems);
+    for (struct Token t = l.next(); t.type != T_EOF; t = l.next()) {
+        if (t.type == T_IMPORT) {
+            struct Token sym = l.next();
+            if (sym.type == T_IDENTIFIER) {
+                imports.push_back(source.str(sym) + ".tmd");
+            }
+        }
+    }
+    return imports;
+}
+
 void Semant::extract_global_declarations(const std::string& module_file) {
     read(module_file);
     lex();
     parse();
-    for (Ast* n: m_nodes) {
-        AstFunDef* f = dynamic_cast<AstFunDef*>(n);
-        if (f) {
+    for (AstId id: m_nodes) {
+        const AstNode& f = m_tree[id];
+        if (f.m_kind == AstKind::FunDef) {
             //if function definition, grab type info...
-            std::string fun_name = std::string(f->m_symbol.start, f->m_symbol.len);
-            std::vector<Type> ptypes = std::vector<Type>();
+            std::vector<TypeId> ptypes = std::vector<TypeId>();
 
-            for (Ast* n: f->m_params) {
-                EmitTacResult r = n->emit_ir(*this); //NOTE: this only returns type and does not actually add quads
+            const AstId* params = m_tree.list(f.m_a);
+            for (uint32_t i = 0; i < f.m_b; i++) {
+                EmitTacResult r = emit_ir(params[i]); //NOTE: this only returns type and does not actually add quads
                 ptypes.push_back(r.m_type); //NOTE: parameters should NOT emit any code
             }
             
-            if (m_globals.m_symbols.find(fun_name) != m_globals.m_symbols.end()) {
-                ems.add_error(f->m_symbol.line, "Syntax Error: Function with name already declared in global scope.");
+            if (m_globals.m_symbols.find(f.m_sym) != m_globals.m_symbols.end()) {
+                m_ems.add_error(m_source.line(f.m_t), "Syntax Error: Function with name already declared in global scope.");
             } else {
-                m_globals.m_symbols.insert({fun_name, Symbol(fun_name, "", Type(T_FUN_TYPE, f->m_ret_type.type, ptypes), 0)});
+                m_globals.m_symbols.insert({f.m_sym, Symbol(f.m_sym, Interner::EMPTY, types.function(types.primitive((enum TokenType)f.m_aux), ptypes), 0)});
             }
         }
     }
+    //only the global declarations outlive this call, so the imported module's tree can go
+    m_nodes.clear();
+    m_tree.clear();
 }
-
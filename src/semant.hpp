@@ -2,6 +2,7 @@
 #define SEMANT_HPP
 
 #include <string>
+#include <array>
 #include <vector>
 #include <unordered_map>
 #include <stdarg.h>
@@ -14,38 +15,50 @@
 #include "error.hpp"
 #include "tac.hpp"
 #include "x86_frame.hpp"
+#include "source_buffer.hpp"
+#include "module_cache.hpp"
 
 class Semant {
 
     class TmdParser: public Parser {
         public:
-            std::vector<Ast*> parse_tokens(const std::vector<struct Token>& tokens) override {
-                m_tokens = tokens;
-                m_current = 0;
-
+            //binding power of each binary operator - higher binds tighter, 0 means not a binary operator
+            inline static constexpr std::array<uint8_t, T_TOKEN_COUNT> s_binding_power = [] {
+                std::array<uint8_t, T_TOKEN_COUNT> bp {};
+                bp[T_OR] = 1;
+                bp[T_AND] = 2;
+                bp[T_EQUAL_EQUAL] = 3;
+                bp[T_NOT_EQUAL] = 3;
+                bp[T_LESS] = 4;
+                bp[T_LESS_EQUAL] = 4;
+                bp[T_GREATER] = 4;
+                bp[T_GREATER_EQUAL] = 4;
+                bp[T_PLUS] = 5;
+                bp[T_MINUS] = 5;
+                bp[T_STAR] = 6;
+                bp[T_SLASH] = 6;
+                return bp;
+            }();
+        public:
+            std::vector<AstId> parse_tokens() override {
                 while (!end_of_tokens()) {
                     m_nodes.push_back(parse_stmt());
                 }
                 return m_nodes;
             }
         private:
-            Ast *parse_group();
-            Ast *parse_literal();
-            Ast *parse_unary();
-            Ast *parse_factor();
-            Ast *parse_term();
-            Ast *parse_inequality();
-            Ast *parse_equality();
-            Ast *parse_and();
-            Ast *parse_or();
-            Ast *parse_assignment();
-            Ast *parse_expr();
-            Ast *parse_block();
-            Ast *parse_stmt();
+            AstId parse_group();
+            AstId parse_literal();
+            AstId parse_unary();
+            AstId parse_binary(uint8_t min_power);
+            AstId parse_assignment();
+            AstId parse_expr();
+            AstId parse_block();
+            AstId parse_stmt();
     };
 
     public:
-        inline static std::vector<struct ReservedWordNew> m_reserved_words {{
+        inline static constexpr KeywordTable m_reserved_words {{
             {"print", T_PRINT},
             {"int", T_INT_TYPE},
             {"bool", T_BOOL_TYPE},
@@ -62,34 +75,52 @@ class Semant {
             {"import", T_IMPORT}
         }};
     public:
-        std::string m_code = "";
-        std::vector<struct Token> m_tokens;
-        int m_current = 0;
-        std::vector<Ast*> m_nodes;
-        Lexer m_lexer;
+        SourceBuffer m_source;
+        AstTree m_tree;
+        std::vector<AstId> m_nodes;
         TmdParser m_parser;
         std::vector<uint8_t> m_buf;
-        std::vector<uint8_t> m_irbuf;
-        std::vector<TacQuad> m_quads;
-        std::vector<std::string> m_tac_labels;
-        std::unordered_map<std::string, X86Frame>* m_frames;
+        std::vector<TacFunction> m_functions;
+        BlockId m_block = BLOCK_NONE; //block of m_functions.back() that new quads are appended to
+        bool m_after_return = false;
+        std::unordered_map<SymbolId, X86Frame>* m_frames;
+        ErrorMsgs& m_ems;
 
 //        Environment m_env;
         int m_label_id_counter = 0;
-        Ast* m_compiling_fun = nullptr;
+        AstId m_compiling_fun = AST_NONE;
         Scope m_globals;
-        std::vector<Semant*> m_imports;
+        std::vector<const ModuleInterface*> m_imports;
     public:
-        Semant(std::unordered_map<std::string, X86Frame>* frames): m_frames(frames) {}
-        void generate_ir(const std::string& input_file, const std::string& output_file);
+        Semant(std::unordered_map<SymbolId, X86Frame>* frames, ErrorMsgs& ems): m_frames(frames), m_ems(ems) {}
+        void generate_ir(const std::string& input_file);
         void write_op(const char* format, ...);
         int generate_label_id();
+        SymbolId new_label();
         void extract_global_declarations(const std::string& module_file);
-        void write_ir(const char* format, ...);
-        void add_tac_label(const std::string& label);
-        void insert_return_labels();
+        static std::vector<std::string> find_imports(SourceBuffer& source);
+        void begin_function(SymbolId name);
+        void add_tac_label(SymbolId label);
+        InstrId emit(const TacQuad& q);
         X86Frame* get_compiling_frame();
     private: 
+        EmitTacResult emit_ir(AstId id);
+        EmitTacResult emit_binary(const AstNode& n);
+        EmitTacResult emit_unary(const AstNode& n);
+        EmitTacResult emit_literal(const AstNode& n);
+        EmitTacResult emit_print(const AstNode& n);
+        EmitTacResult emit_fun_def(AstId id);
+        EmitTacResult emit_decl_sym(const AstNode& n);
+        EmitTacResult emit_get_sym(const AstNode& n);
+        EmitTacResult emit_set_sym(const AstNode& n);
+        EmitTacResult emit_block(const AstNode& n);
+        EmitTacResult emit_if(const AstNode& n);
+        EmitTacResult emit_while(const AstNode& n);
+        EmitTacResult emit_call(const AstNode& n);
+        EmitTacResult emit_return(const AstNode& n);
+        EmitTacResult emit_import(const AstNode& n);
+        int find_param(SymbolId symbol);
+
         void read(const std::string& input_file);
         void lex();
         void parse();
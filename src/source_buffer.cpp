@@ -0,0 +1,60 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "source_buffer.hpp"
+
+SourceBuffer::~SourceBuffer() {
+    close();
+}
+
+bool SourceBuffer::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    //mmap rejects zero-length mappings, so empty files are just an empty view
+    if (st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        m_data = (const char*)p;
+        m_size = st.st_size;
+        m_mapped = true;
+    }
+
+    ::close(fd); //mapping stays valid after the descriptor is closed
+    return true;
+}
+
+void SourceBuffer::assign(std::string_view text) {
+    close();
+    m_data = text.data();
+    m_size = text.size();
+}
+
+int SourceBuffer::line_at(uint32_t off) const {
+    //lines are 1-based: count the newlines before the offset
+    return 1 + (std::lower_bound(m_newlines.begin(), m_newlines.end(), off) - m_newlines.begin());
+}
+
+void SourceBuffer::close() {
+    if (m_mapped) {
+        munmap((void*)m_data, m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_newlines.clear();
+}
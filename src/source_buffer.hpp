@@ -0,0 +1,53 @@
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "token.hpp"
+
+/*
+ * Read-only view of a source file.
+ * The file is memory-mapped, and tokens are offsets into the mapping,
+ * so the buffer must outlive every token lexed from it.
+ * The Lexer records newline offsets as it goes, and line numbers are
+ * only computed from them when an error is reported.
+ */
+class SourceBuffer {
+    private:
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_mapped = false;
+        std::vector<uint32_t> m_newlines;
+    public:
+        SourceBuffer() {}
+        ~SourceBuffer();
+        SourceBuffer(const SourceBuffer&) = delete;
+        SourceBuffer& operator=(const SourceBuffer&) = delete;
+        bool open(const std::string& path);
+        void assign(std::string_view text);
+        void close();
+        std::string_view view() const {
+            return std::string_view(m_data ? m_data : "", m_size);
+        }
+        const char* start(const struct Token& t) const {
+            return m_data + t.off;
+        }
+        std::string_view text(const struct Token& t) const {
+            return std::string_view(m_data + t.off, t.len);
+        }
+        std::string str(const struct Token& t) const {
+            return std::string(m_data + t.off, t.len);
+        }
+        void add_newline(uint32_t off) {
+            m_newlines.push_back(off);
+        }
+        int line_at(uint32_t off) const;
+        int line(const struct Token& t) const {
+            return line_at(t.off);
+        }
+};
+
+#endif //SOURCE_BUFFER_HPP
@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <string>
+
+#include "ssa.hpp"
+
+
+SSATransformer::SSATransformer(TacFunction* fn, X86Frame* frame):
+    m_fn(fn), m_frame(frame), m_cfg(*fn), m_dom(m_cfg), m_vars(*fn), m_phis(fn->m_blocks.size()) {
+    for (uint32_t v = 0; v < m_vars.size(); v++) {
+        m_versions.push_back({m_vars.m_names[v], v});
+        m_version_ids.insert({m_vars.m_names[v], v});
+    }
+    m_next_version.assign(m_vars.size(), 1);
+    m_renamed.assign(m_vars.size(), false);
+    m_defined_once.assign(m_vars.size(), false);
+    for (const std::pair<const SymbolId, Symbol>& p: frame->m_symbols) {
+        m_lowest_offset = std::min(m_lowest_offset, p.second.m_fp_offset);
+    }
+}
+
+void SSATransformer::construct() {
+    place_phis();
+    rename();
+}
+
+//a fresh name for another definition of var, which passes may add as well
+SymbolId SSATransformer::new_version(uint32_t var) {
+    m_renamed[var] = true;
+    m_defined_once[var] = false;
+    SymbolId name = interner.intern(interner.str(m_vars.m_names[var]) + "." + std::to_string(m_next_version[var]++));
+    m_version_ids.insert({name, (uint32_t)m_versions.size()});
+    m_versions.push_back({name, var});
+    return name;
+}
+
+void SSATransformer::place_phis() {
+    size_t n = m_fn->m_blocks.size();
+    Liveness live(*m_fn, m_cfg);
+    std::vector<std::vector<BlockId>> df = m_dom.frontiers(m_cfg);
+
+    std::vector<std::vector<BlockId>> def_blocks(m_vars.size());
+    std::vector<uint32_t> def_counts(m_vars.size(), 0);
+    for (BlockId b = 0; b < n; b++) {
+        for (InstrId i = m_fn->m_blocks[b].m_first; i != INSTR_NONE; i = m_fn->next(i)) {
+            const TacQuad& q = m_fn->quad(i);
+            if (!q.defines_target() || q.target().m_kind != OpdKind::Var) continue;
+            uint32_t v = m_vars.id(q.m_values[TacQuad::TARGET]);
+            def_counts[v]++;
+            if (def_blocks[v].empty() || def_blocks[v].back() != b) def_blocks[v].push_back(b);
+        }
+    }
+
+    //has_phi and queued hold the last variable each block was handled for, so they never need clearing
+    std::vector<uint32_t> has_phi(n, VarIndex::NONE);
+    std::vector<uint32_t> queued(n, VarIndex::NONE);
+    std::vector<BlockId> work;
+    for (uint32_t v = 0; v < m_vars.size(); v++) {
+        work = def_blocks[v];
+        for (BlockId b: work) {
+            queued[b] = v;
+        }
+        while (!work.empty()) {
+            BlockId x = work.back();
+            work.pop_back();
+            for (BlockId y: df[x]) {
+                //pruned: a variable dead on entry to the join needs no phi there
+                if (has_phi[y] == v || !live.m_in[y].test(v)) continue;
+                has_phi[y] = v;
+                m_renamed[v] = true;
+                size_t preds = m_cfg.m_blocks[y].m_preds.size();
+                m_phis[y].push_back({m_vars.m_names[v], v, std::vector<Operand>(preds, Operand::var(m_vars.m_names[v]))});
+                if (queued[y] != v) {
+                    queued[y] = v;
+                    work.push_back(y);
+                }
+            }
+        }
+        //a single definition can share the name with the value on entry only if that is never read
+        if (def_counts[v] > 1 || (def_counts[v] == 1 && live.m_in[ControlFlowGraph::ENTRY].test(v))) m_renamed[v] = true;
+        m_defined_once[v] = def_counts[v] == 1 && !m_renamed[v];
+    }
+}
+
+void SSATransformer::rename() {
+    //the current version of each variable is the top of its stack, or the variable itself when empty
+    std::vector<std::vector<SymbolId>> stacks(m_vars.size());
+    std::vector<uint32_t> pushed; //variables pushed so far, popped back to a mark when leaving a block
+    auto current = [&](uint32_t v) {
+        return stacks[v].empty() ? m_vars.m_names[v] : stacks[v].back();
+    };
+    auto define = [&](uint32_t v) {
+        if (!m_renamed[v]) return m_vars.m_names[v];
+        SymbolId name = new_version(v);
+        stacks[v].push_back(name);
+        pushed.push_back(v);
+        return name;
+    };
+
+    std::vector<size_t> marks(m_fn->m_blocks.size());
+    m_dom.walk([&](BlockId b) {
+        marks[b] = pushed.size();
+        for (Phi& phi: m_phis[b]) {
+            phi.m_target = define(phi.m_var);
+        }
+        for (InstrId i = m_fn->m_blocks[b].m_first; i != INSTR_NONE; i = m_fn->next(i)) {
+            TacQuad& q = m_fn->quad(i);
+            for (int o = 0; o < 3; o++) {
+                if (o == TacQuad::TARGET && q.defines_target()) continue;
+                if (q.m_kinds[o] == OpdKind::Var) {
+                    q.m_values[o] = current(m_vars.id(q.m_values[o]));
+                }
+            }
+            if (q.defines_target() && q.target().m_kind == OpdKind::Var) {
+                q.m_values[TacQuad::TARGET] = define(m_vars.id(q.m_values[TacQuad::TARGET]));
+            }
+        }
+        for (BlockId s: m_cfg.m_blocks[b].m_succs) {
+            size_t j = m_cfg.pred_index(s, b);
+            for (Phi& phi: m_phis[s]) {
+                phi.m_args[j] = Operand::var(current(phi.m_var));
+            }
+        }
+    }, [&](BlockId b) {
+        while (pushed.size() > marks[b]) {
+            stacks[pushed.back()].pop_back();
+            pushed.pop_back();
+        }
+    });
+}
+
+SymbolId SSATransformer::new_label() {
+    return interner.intern("_L" + interner.str(m_fn->m_name) + "_" + std::to_string(m_label_counter++));
+}
+
+std::vector<SymbolId> SSATransformer::pred_labels(BlockId b) const {
+    std::vector<SymbolId> labels;
+    for (BlockId p: m_cfg.m_blocks[b].m_preds) {
+        labels.push_back(m_fn->m_blocks[p].m_label);
+    }
+    return labels;
+}
+
+/*
+ * Rebuilds m_cfg and m_dom from the jumps as they are now, once m_phis lines up with the blocks again.
+ * Each phi argument follows its edge by the predecessor's label in pred_labels, since blocks are
+ * renumbered and predecessor lists reordered; arguments for edges that no longer exist are dropped.
+ */
+void SSATransformer::rebuild(const std::vector<std::vector<SymbolId>>& pred_labels) {
+    m_cfg = ControlFlowGraph(*m_fn);
+    m_dom = DominatorTree(m_cfg);
+
+    for (BlockId b = 0; b < m_phis.size(); b++) {
+        const std::vector<BlockId>& preds = m_cfg.m_blocks[b].m_preds;
+        for (Phi& phi: m_phis[b]) {
+            std::vector<Operand> args;
+            for (BlockId p: preds) {
+                std::vector<SymbolId>::const_iterator old = std::find(pred_labels[b].begin(), pred_labels[b].end(), m_fn->m_blocks[p].m_label);
+                args.push_back(old == pred_labels[b].end() ? Operand::var(m_vars.m_names[phi.m_var]) : phi.m_args[old - pred_labels[b].begin()]);
+            }
+            phi.m_args = std::move(args);
+        }
+    }
+}
+
+//drops the blocks flagged in dead
+void SSATransformer::remove_blocks(const std::vector<bool>& dead) {
+    std::vector<std::vector<SymbolId>> labels;
+    std::vector<std::vector<Phi>> phis;
+    for (BlockId b = 0; b < m_fn->m_blocks.size(); b++) {
+        if (dead[b]) continue;
+        labels.push_back(pred_labels(b));
+        phis.push_back(std::move(m_phis[b]));
+    }
+
+    m_fn->remove_blocks(dead);
+    m_phis = std::move(phis);
+    rebuild(labels);
+}
+
+//points block's jumps to from at to instead
+void SSATransformer::retarget(BlockId block, SymbolId from, SymbolId to) {
+    if (m_fn->m_blocks[block].m_last == INSTR_NONE) return;
+    TacQuad& jump = m_fn->quad(m_fn->m_blocks[block].m_last);
+    for (int o = TacQuad::OPD1; o <= TacQuad::OPD2; o++) {
+        if (jump.opd(o) == Operand::label(from)) jump.set_opd(o, Operand::label(to));
+    }
+}
+
+/*
+ * Puts a new block right ahead of loop's header for every edge entering the loop to go through,
+ * and returns it. The header's phis take a single argument from it in place of those edges',
+ * and where they differ a phi in the new block merges them first.
+ */
+BlockId SSATransformer::insert_preheader(const Loop& loop) {
+    BlockId header = loop.m_header;
+    SymbolId header_label = m_fn->m_blocks[header].m_label;
+    SymbolId label = new_label();
+    const std::vector<BlockId>& preds = m_cfg.m_blocks[header].m_preds;
+    auto is_latch = [&](BlockId p) {
+        return std::find(loop.m_latches.begin(), loop.m_latches.end(), p) != loop.m_latches.end();
+    };
+
+    std::vector<SymbolId> entering_labels;
+    std::vector<SymbolId> header_labels = {label};
+    for (BlockId p: preds) {
+        (is_latch(p) ? header_labels : entering_labels).push_back(m_fn->m_blocks[p].m_label);
+    }
+    std::vector<Phi> phis;
+    for (Phi& phi: m_phis[header]) {
+        std::vector<Operand> entering;
+        std::vector<Operand> args = {Operand::none()};
+        for (size_t j = 0; j < preds.size(); j++) {
+            (is_latch(preds[j]) ? args : entering).push_back(phi.m_args[j]);
+        }
+        args[0] = entering[0];
+        if (std::any_of(entering.begin(), entering.end(), [&](const Operand& o) { return o != entering[0]; })) {
+            SymbolId name = new_version(phi.m_var);
+            phis.push_back({name, phi.m_var, std::move(entering)});
+            args[0] = Operand::var(name);
+        }
+        phi.m_args = std::move(args);
+    }
+
+    std::vector<std::vector<SymbolId>> labels;
+    for (BlockId b = 0; b < m_fn->m_blocks.size(); b++) {
+        labels.push_back(b == header ? header_labels : pred_labels(b));
+    }
+    for (BlockId p: preds) {
+        if (!is_latch(p)) retarget(p, header_label, label);
+    }
+    //a latch falling into the header now has to jump to it
+    BlockId before = header - 1;
+    if (m_fn->falls_through(before) && is_latch(before)) {
+        TacQuad* last = m_fn->m_blocks[before].m_last == INSTR_NONE ? nullptr : &m_fn->quad(m_fn->m_blocks[before].m_last);
+        if (last && last->m_op == TacT::CondGoto) {
+            last->set_opd2(Operand::label(header_label));
+        } else {
+            m_fn->append(before, TacQuad(Operand::none(), Operand::none(), Operand::label(header_label), TacT::Goto));
+        }
+    }
+
+    m_fn->insert_block(header, label);
+    m_phis.insert(m_phis.begin() + header, std::move(phis));
+    labels.insert(labels.begin() + header, std::move(entering_labels));
+    rebuild(labels);
+    return header;
+}
+
+//numbers the stack locations the variables start out in, giving variables that share a frame slot the same number
+std::vector<uint32_t> SSATransformer::locations() const {
+    std::vector<uint32_t> location(m_vars.size());
+    std::unordered_map<int, uint32_t> by_offset;
+    for (uint32_t v = 0; v < m_vars.size(); v++) {
+        const Symbol* sym = m_frame->get_symbol_from_frame(m_vars.m_names[v]);
+        location[v] = sym ? by_offset.insert({sym->m_fp_offset, v}).first->second : v;
+    }
+    return location;
+}
+
+bool SSATransformer::same_location(SymbolId a, SymbolId b) const {
+    if (a == b) return true;
+    const Symbol* sa = m_frame->get_symbol_from_frame(a);
+    const Symbol* sb = m_frame->get_symbol_from_frame(b);
+    return sa && sb && sa->m_fp_offset == sb->m_fp_offset;
+}
+
+/*
+ * Versions that start out in the same stack location and are live at the same time, so can't stay there.
+ * Only versions sharing a location are compared: the others never share a slot.
+ * A phi's arguments are read at the end of the predecessor they come from and its target is
+ * written at the top of its block, which is where copies will put them on the way out.
+ */
+std::vector<std::vector<uint32_t>> SSATransformer::find_interference() const {
+    size_t n = m_fn->m_blocks.size();
+    size_t nv = m_versions.size();
+    std::vector<std::vector<uint32_t>> interference(nv);
+
+    //only locations holding several versions can have conflicts, so liveness is only tracked for those
+    std::vector<uint32_t> location = locations();
+    std::vector<uint32_t> counts(m_vars.size(), 0);
+    for (uint32_t x = 0; x < nv; x++) {
+        counts[location[m_versions[x].m_var]]++;
+    }
+    std::vector<uint32_t> bits(nv, VarIndex::NONE);
+    std::vector<std::vector<uint32_t>> members(m_vars.size());
+    size_t tracked = 0;
+    for (uint32_t x = 0; x < nv; x++) {
+        uint32_t l = location[m_versions[x].m_var];
+        if (counts[l] < 2) continue;
+        bits[x] = tracked++;
+        members[l].push_back(x);
+    }
+    if (tracked == 0) return interference;
+    auto bit = [&](SymbolId name) { return bits[version_id(name)]; };
+    auto set = [&](BitVector* live, SymbolId name) {
+        if (bit(name) != VarIndex::NONE) live->set(bit(name));
+    };
+    auto reset = [&](BitVector* live, SymbolId name) {
+        if (bit(name) != VarIndex::NONE) live->reset(bit(name));
+    };
+
+    //seeds live with the phi arguments b passes on to its successors
+    auto edge_uses = [&](BlockId b, BitVector* live) {
+        for (BlockId s: m_cfg.m_blocks[b].m_succs) {
+            size_t j = m_cfg.pred_index(s, b);
+            for (const Phi& phi: m_phis[s]) {
+                if (phi.m_args[j].m_kind == OpdKind::Var) set(live, phi.m_args[j].m_value);
+            }
+        }
+    };
+
+    std::vector<BitVector> gen(n, BitVector(tracked));
+    std::vector<BitVector> kill(n, BitVector(tracked));
+    for (BlockId b = 0; b < n; b++) {
+        edge_uses(b, &gen[b]);
+        for (InstrId i = m_fn->m_blocks[b].m_last; i != INSTR_NONE; i = m_fn->m_instrs[i].m_prev) {
+            const TacQuad& q = m_fn->quad(i);
+            if (q.defines_target() && q.target().m_kind == OpdKind::Var) {
+                set(&kill[b], q.m_values[TacQuad::TARGET]);
+                reset(&gen[b], q.m_values[TacQuad::TARGET]);
+            }
+            for_each_use(q, [&](SymbolId name) { set(&gen[b], name); });
+        }
+        for (const Phi& phi: m_phis[b]) {
+            set(&kill[b], phi.m_target);
+            reset(&gen[b], phi.m_target);
+        }
+    }
+    DataflowResult live_sets = solve_dataflow(m_cfg, Direction::Backward, Meet::Union, tracked, gen, kill, BitVector(tracked));
+
+    auto interfere_live = [&](SymbolId def, const BitVector& live, Operand copied) {
+        uint32_t d = version_id(def);
+        if (bits[d] == VarIndex::NONE) return;
+        for (uint32_t w: members[location[m_versions[d].m_var]]) {
+            if (w == d || !live.test(bits[w])) continue;
+            //d = w leaves both holding the same value, so they can still share a slot
+            if (copied.m_kind == OpdKind::Var && version_id(copied.m_value) == w) continue;
+            interference[d].push_back(w);
+            interference[w].push_back(d);
+        }
+    };
+    for (BlockId b = 0; b < n; b++) {
+        BitVector live = live_sets.m_out[b];
+        edge_uses(b, &live);
+        for (InstrId i = m_fn->m_blocks[b].m_last; i != INSTR_NONE; i = m_fn->m_instrs[i].m_prev) {
+            const TacQuad& q = m_fn->quad(i);
+            if (q.defines_target() && q.target().m_kind == OpdKind::Var) {
+                interfere_live(q.m_values[TacQuad::TARGET], live, q.m_op == TacT::Assign ? q.opd1() : Operand::none());
+                reset(&live, q.m_values[TacQuad::TARGET]);
+            }
+            for_each_use(q, [&](SymbolId name) { set(&live, name); });
+        }
+        for (const Phi& phi: m_phis[b]) {
+            interfere_live(phi.m_target, live, Operand::none());
+        }
+    }
+
+    for (std::vector<uint32_t>& list: interference) {
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+    }
+    return interference;
+}
+
+/*
+ * Greedily packs each variable's versions into as few slots as possible, the variable's own slot first.
+ * The value on entry has to stay in it, but the one definition of a variable that kept its name can
+ * move like any other version, taking every use of the name along.
+ */
+std::vector<SymbolId> SSATransformer::assign_slots(const std::vector<std::vector<uint32_t>>& interference) {
+    size_t nv = m_versions.size();
+    std::vector<SymbolId> slots(nv);
+    std::vector<std::vector<SymbolId>> var_slots(m_vars.size());
+    std::vector<bool> taken;
+
+    //versions are numbered after their variable, so each variable claims its own slot first
+    for (uint32_t x = 0; x < nv; x++) {
+        uint32_t v = m_versions[x].m_var;
+        std::vector<SymbolId>& candidates = var_slots[v];
+        if (candidates.empty()) candidates.push_back(m_vars.m_names[v]);
+        taken.assign(candidates.size(), false);
+        if (x != v || m_defined_once[v]) {
+            for (uint32_t w: interference[x]) {
+                if (w > x) continue;
+                for (size_t s = 0; s < candidates.size(); s++) {
+                    if (same_location(candidates[s], slots[w])) taken[s] = true;
+                }
+            }
+        }
+
+        size_t s = std::find(taken.begin(), taken.end(), false) - taken.begin();
+        if (s == candidates.size()) {
+            //the version keeping the variable's name needs another for its new slot
+            SymbolId name = x == v ? interner.intern(interner.str(m_vars.m_names[v]) + ".0") : m_versions[x].m_name;
+            const Symbol* var = m_frame->get_symbol_from_frame(m_vars.m_names[v]);
+            candidates.push_back(add_slot(name, var ? var->m_type : types.INT));
+        }
+        slots[x] = candidates[s];
+    }
+    return slots;
+}
+
+//reserves another 4 bytes below the frame's slots, growing FunBegin's frame size to match if needed
+SymbolId SSATransformer::add_slot(SymbolId name, TypeId type) {
+    TacQuad& begin = m_fn->quad(m_fn->m_blocks[ControlFlowGraph::ENTRY].m_first);
+    m_lowest_offset -= 4;
+    m_frame->m_symbols.insert({name, Symbol(name, name, type, m_lowest_offset)});
+    begin.set_opd2(Operand::imm(std::max(begin.opd2().imm(), -m_lowest_offset)));
+    return name;
+}
+
+//orders the parallel copies (dst, src) so no source is overwritten before it is read
+std::vector<TacQuad> SSATransformer::sequentialize(std::vector<std::pair<Operand, Operand>> copies, SymbolId* scratch) {
+    std::vector<TacQuad> ordered;
+    while (!copies.empty()) {
+        bool progress = false;
+        for (size_t i = 0; i < copies.size();) {
+            Operand dst = copies[i].first;
+            bool read = std::any_of(copies.begin(), copies.end(), [&](const std::pair<Operand, Operand>& c) {
+                return c.second == dst;
+            });
+            if (read) {
+                i++;
+                continue;
+            }
+            ordered.push_back(TacQuad(dst, copies[i].second, Operand::none(), TacT::Assign));
+            copies.erase(copies.begin() + i);
+            progress = true;
+        }
+        if (progress) continue;
+
+        //every copy left is on a cycle: park one destination's old value so it can be overwritten
+        if (*scratch == Interner::EMPTY) {
+            *scratch = add_slot(interner.intern("_swap"), types.INT);
+        }
+        Operand dst = copies[0].first;
+        ordered.push_back(TacQuad(Operand::var(*scratch), dst, Operand::none(), TacT::Assign));
+        for (std::pair<Operand, Operand>& c: copies) {
+            if (c.second == dst) c.second = Operand::var(*scratch);
+        }
+    }
+    return ordered;
+}
+
+/*
+ * Gives the edge pred -> succ a block of its own to hold copies.
+ * It goes right before succ and falls into it when the block ahead of succ doesn't fall through,
+ * otherwise right after pred, which ends in a CondGoto, with a Goto to succ.
+ */
+void SSATransformer::split_edge(BlockId pred, BlockId succ, const std::vector<TacQuad>& copies) {
+    SymbolId succ_label = m_fn->m_blocks[succ].m_label;
+    SymbolId label = new_label();
+    retarget(pred, succ_label, label);
+
+    bool before_succ = !m_fn->falls_through(succ - 1);
+    BlockId block = m_fn->insert_block(before_succ ? succ : pred + 1, label);
+    for (const TacQuad& q: copies) {
+        m_fn->append(block, q);
+    }
+    if (!before_succ) {
+        m_fn->append(block, TacQuad(Operand::none(), Operand::none(), Operand::label(succ_label), TacT::Goto));
+    }
+}
+
+void SSATransformer::destruct() {
+    std::vector<SymbolId> slots = assign_slots(find_interference());
+    auto slot_of = [&](Operand o) {
+        return o.m_kind == OpdKind::Var ? Operand::var(slots[version_id(o.m_value)]) : o;
+    };
+
+    for (TacBlock& b: m_fn->m_blocks) {
+        for (InstrId i = b.m_first; i != INSTR_NONE; i = m_fn->next(i)) {
+            TacQuad& q = m_fn->quad(i);
+            for (int o = 0; o < 3; o++) {
+                q.set_opd(o, slot_of(q.opd(o)));
+            }
+        }
+    }
+
+    //the copies each edge needs, with its ends recorded by label since splitting renumbers blocks
+    struct EdgeCopies {
+        SymbolId m_pred;
+        SymbolId m_succ;
+        bool m_only_pred; //whether pred is succ's only predecessor
+        std::vector<std::pair<Operand, Operand>> m_copies;
+    };
+    std::vector<EdgeCopies> edges;
+    for (BlockId s = 0; s < m_phis.size(); s++) {
+        const std::vector<BlockId>& preds = m_cfg.m_blocks[s].m_preds;
+        for (size_t j = 0; j < preds.size(); j++) {
+            EdgeCopies e{m_fn->m_blocks[preds[j]].m_label, m_fn->m_blocks[s].m_label, preds.size() == 1, {}};
+            for (const Phi& phi: m_phis[s]) {
+                Operand dst = slot_of(Operand::var(phi.m_target));
+                Operand src = slot_of(phi.m_args[j]);
+                if (dst != src) e.m_copies.push_back({dst, src});
+            }
+            if (!e.m_copies.empty()) edges.push_back(std::move(e));
+        }
+    }
+    m_phis.clear();
+
+    SymbolId scratch = Interner::EMPTY;
+    for (EdgeCopies& e: edges) {
+        std::vector<TacQuad> copies = sequentialize(std::move(e.m_copies), &scratch);
+        BlockId pred = m_fn->block_of(e.m_pred);
+        BlockId succ = m_fn->block_of(e.m_succ);
+        const TacBlock& p = m_fn->m_blocks[pred];
+        bool branches = p.m_last != INSTR_NONE && m_fn->quad(p.m_last).m_op == TacT::CondGoto;
+
+        if (!branches) {
+            //pred only leads to succ: copy ahead of its Goto, if it has one
+            InstrId pos = p.m_last != INSTR_NONE && m_fn->quad(p.m_last).m_op == TacT::Goto ? p.m_last : INSTR_NONE;
+            for (const TacQuad& q: copies) {
+                m_fn->insert_before(pred, pos, q);
+            }
+        } else if (e.m_only_pred) {
+            InstrId pos = m_fn->m_blocks[succ].m_first;
+            for (const TacQuad& q: copies) {
+                m_fn->insert_before(succ, pos, q);
+            }
+        } else {
+            split_edge(pred, succ, copies);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef SSA_HPP
+#define SSA_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "tac.hpp"
+#include "x86_frame.hpp"
+#include "ControlFlowGraph.hpp"
+#include "dominator_tree.hpp"
+#include "dataflow.hpp"
+
+//one SSA name: a variable's value on entry (version i == variable i) or the result of one definition
+struct SsaVersion {
+    SymbolId m_name;
+    uint32_t m_var; //index into SSATransformer::m_vars
+};
+
+//m_target = the m_args entry of the edge control arrived by
+struct Phi {
+    SymbolId m_target;
+    uint32_t m_var;
+    std::vector<Operand> m_args; //one per predecessor, in the order of the block's m_preds
+};
+
+/*
+ * Puts one function into pruned SSA form and takes it back out again.
+ *
+ * construct() places phis on the iterated dominance frontiers of each variable's definitions,
+ * where the variable is live, then renames every definition to a fresh version (named "var.n")
+ * walking the dominator tree. A variable written once and needing no phi is already in SSA form
+ * and keeps its name. Phis are kept beside the blocks in m_phis, not in the quad lists.
+ *
+ * destruct() gives each variable's versions back the variable's own stack slot unless their
+ * live ranges interfere, in which case the interfering ones get new slots. Variables of sibling
+ * scopes share a slot in the frame, and passes that lengthen live ranges can make them overlap,
+ * so versions are checked against every version kept in the same place. Then it lowers the phis
+ * to parallel copies on the incoming edges. Those are sequentialized, using a scratch slot to
+ * break cycles, and edges from blocks with several successors are split to hold them.
+ * m_cfg and m_dom describe the function while it is in SSA form, not afterwards. Passes that
+ * rewrite jumps or drop blocks in between call remove_blocks() to bring them up to date, and
+ * insert_preheader() adds a block keeping them, and the phis, in step.
+ */
+class SSATransformer {
+    public:
+        TacFunction* m_fn;
+        X86Frame* m_frame;
+        ControlFlowGraph m_cfg;
+        DominatorTree m_dom;
+        VarIndex m_vars; //the variables as they were before construct()
+        std::vector<SsaVersion> m_versions;
+        std::unordered_map<SymbolId, uint32_t> m_version_ids;
+        std::vector<std::vector<Phi>> m_phis; //per block
+    private:
+        std::vector<uint32_t> m_next_version; //per variable, the number the next version's name gets
+        std::vector<bool> m_renamed; //per variable, false when its one definition can keep the variable's name
+        std::vector<bool> m_defined_once; //per variable, true when version v is that one definition rather than the value on entry
+        uint32_t m_label_counter = 0;
+        int m_lowest_offset = 0; //of the frame's slots, below which add_slot() puts new ones
+    public:
+        SSATransformer(TacFunction* fn, X86Frame* frame);
+        void construct();
+        void destruct();
+        void remove_blocks(const std::vector<bool>& dead);
+        BlockId insert_preheader(const Loop& loop);
+        SymbolId new_version(uint32_t var);
+        uint32_t version_id(SymbolId name) const {
+            std::unordered_map<SymbolId, uint32_t>::const_iterator it = m_version_ids.find(name);
+            return it == m_version_ids.end() ? VarIndex::NONE : it->second;
+        }
+    private:
+        void place_phis();
+        void rename();
+        SymbolId new_label();
+        std::vector<SymbolId> pred_labels(BlockId b) const;
+        void rebuild(const std::vector<std::vector<SymbolId>>& pred_labels);
+        void retarget(BlockId block, SymbolId from, SymbolId to);
+        std::vector<uint32_t> locations() const;
+        bool same_location(SymbolId a, SymbolId b) const;
+        std::vector<std::vector<uint32_t>> find_interference() const;
+        std::vector<SymbolId> assign_slots(const std::vector<std::vector<uint32_t>>& interference);
+        SymbolId add_slot(SymbolId name, TypeId type);
+        std::vector<TacQuad> sequentialize(std::vector<std::pair<Operand, Operand>> copies, SymbolId* scratch);
+        void split_edge(BlockId pred, BlockId succ, const std::vector<TacQuad>& copies);
+};
+
+#endif //SSA_HPP
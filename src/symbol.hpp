@@ -1,24 +1,37 @@
 #ifndef SYMBOL_HPP
 #define SYMBOL_HPP
 
+#include <unordered_map>
+
+#include "type.hpp"
+#include "interner.hpp"
+
 class Symbol {
     public:
-        std::string m_name;
-        std::string m_tac_name;
-        Type m_type;
+        SymbolId m_name;
+        SymbolId m_tac_name;
+        TypeId m_type;
         int m_fp_offset;
     public:
-        Symbol(const std::string& name, const std::string& tac_name, Type type, int fp_offset):
+        Symbol(SymbolId name, SymbolId tac_name, TypeId type, int fp_offset):
             m_name(name), m_tac_name(tac_name), m_type(type), m_fp_offset(fp_offset) {}
 };
 
 
 class Scope {
     public:
-        std::unordered_map<std::string, Symbol> m_symbols;
+        std::unordered_map<SymbolId, Symbol> m_symbols;
     public:
-        Symbol* get_symbol(const std::string& name) {
-            std::unordered_map<std::string, Symbol>::iterator it = m_symbols.find(name);
+        Symbol* get_symbol(SymbolId name) {
+            std::unordered_map<SymbolId, Symbol>::iterator it = m_symbols.find(name);
+            if (it != m_symbols.end()) {
+                return &(it->second);
+            }
+
+            return nullptr;
+        }
+        const Symbol* get_symbol(SymbolId name) const {
+            std::unordered_map<SymbolId, Symbol>::const_iterator it = m_symbols.find(name);
             if (it != m_symbols.end()) {
                 return &(it->second);
             }
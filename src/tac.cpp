@@ -1,3 +1,107 @@
 #include "tac.hpp"
 
-int TacQuad::s_label_counter = 0;
+
+BlockId TacFunction::add_block(SymbolId label) {
+    BlockId id = m_blocks.size();
+    m_blocks.push_back({label});
+    m_labels.insert({label, id});
+    return id;
+}
+
+//puts a new block at pos in the layout, renumbering the blocks after it
+BlockId TacFunction::insert_block(BlockId pos, SymbolId label) {
+    m_blocks.insert(m_blocks.begin() + pos, TacBlock{label});
+    for (BlockId i = pos; i < m_blocks.size(); i++) {
+        m_labels[m_blocks[i].m_label] = i;
+    }
+    return pos;
+}
+
+InstrId TacFunction::append(BlockId block, const TacQuad& q) {
+    TacBlock& b = m_blocks[block];
+    InstrId id = m_instrs.size();
+    m_instrs.push_back({q, b.m_last, INSTR_NONE});
+    if (b.m_last == INSTR_NONE) {
+        b.m_first = id;
+    } else {
+        m_instrs[b.m_last].m_next = id;
+    }
+    b.m_last = id;
+    return id;
+}
+
+InstrId TacFunction::insert_before(BlockId block, InstrId pos, const TacQuad& q) {
+    if (pos == INSTR_NONE) {
+        return append(block, q);
+    }
+
+    TacBlock& b = m_blocks[block];
+    InstrId id = m_instrs.size();
+    InstrId prev = m_instrs[pos].m_prev;
+    m_instrs.push_back({q, prev, pos});
+    m_instrs[pos].m_prev = id;
+    if (prev == INSTR_NONE) {
+        b.m_first = id;
+    } else {
+        m_instrs[prev].m_next = id;
+    }
+    return id;
+}
+
+void TacFunction::remove(BlockId block, InstrId id) {
+    TacBlock& b = m_blocks[block];
+    TacInstr& instr = m_instrs[id];
+    if (instr.m_prev == INSTR_NONE) {
+        b.m_first = instr.m_next;
+    } else {
+        m_instrs[instr.m_prev].m_next = instr.m_next;
+    }
+    if (instr.m_next == INSTR_NONE) {
+        b.m_last = instr.m_prev;
+    } else {
+        m_instrs[instr.m_next].m_prev = instr.m_prev;
+    }
+    instr.m_prev = INSTR_NONE;
+    instr.m_next = INSTR_NONE;
+}
+
+//drops the blocks flagged in dead, keeping the rest in layout order
+void TacFunction::remove_blocks(const std::vector<bool>& dead) {
+    std::vector<TacBlock> live;
+    m_labels.clear();
+    for (BlockId i = 0; i < m_blocks.size(); i++) {
+        if (dead[i]) continue;
+        m_labels.insert({m_blocks[i].m_label, (BlockId)live.size()});
+        live.push_back(m_blocks[i]);
+    }
+    m_blocks = std::move(live);
+}
+
+//a block falls through to the next one unless it ends in an unconditional transfer
+bool TacFunction::falls_through(BlockId block) const {
+    const TacBlock& b = m_blocks[block];
+    if (b.m_last == INSTR_NONE) return true;
+    const TacQuad& q = quad(b.m_last);
+    switch (q.m_op) {
+        case TacT::Goto:
+        case TacT::Return:
+        case TacT::Exit:
+        case TacT::FunEnd:
+            return false;
+        case TacT::CondGoto:
+            return q.opd2().is_none();
+        default:
+            return true;
+    }
+}
+
+void print_tac(const std::vector<TacFunction>& functions) {
+    for (const TacFunction& fn: functions) {
+        for (const TacBlock& b: fn.m_blocks) {
+            std::cout << interner.view(b.m_label) << ":" << std::endl;
+            for (InstrId i = b.m_first; i != INSTR_NONE; i = fn.next(i)) {
+                std::cout << "    " << fn.quad(i).to_string() << std::endl;
+            }
+        }
+    }
+}
@@ -3,16 +3,57 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <type_traits>
 #include "type.hpp"
+#include "interner.hpp"
+
+enum class OpdKind: uint8_t {
+    None,
+    Imm,    //m_value is the int32 value
+    Var,    //m_value is the SymbolId of a frame slot: a parameter, local or temp
+    Label,  //m_value is the SymbolId of a block label
+    Fun     //m_value is the SymbolId of a function, possibly defined in another module
+};
+
+/*
+ * Tagged operand handle. Names are only kept in the interner, so operands compare and copy as integers.
+ */
+struct Operand {
+    OpdKind m_kind;
+    uint32_t m_value;
+
+    static Operand none() { return {OpdKind::None, 0}; }
+    static Operand imm(int32_t value) { return {OpdKind::Imm, (uint32_t)value}; }
+    static Operand var(SymbolId id) { return {OpdKind::Var, id}; }
+    static Operand label(SymbolId id) { return {OpdKind::Label, id}; }
+    static Operand fun(SymbolId id) { return {OpdKind::Fun, id}; }
+
+    bool is_none() const { return m_kind == OpdKind::None; }
+    bool is_imm() const { return m_kind == OpdKind::Imm; }
+    bool is_imm(int32_t value) const { return m_kind == OpdKind::Imm && (int32_t)m_value == value; }
+    int32_t imm() const { return (int32_t)m_value; }
+    bool operator==(const Operand& other) const { return m_kind == other.m_kind && m_value == other.m_value; }
+    bool operator!=(const Operand& other) const { return !(*this == other); }
+
+    std::string to_string() const {
+        switch (m_kind) {
+            case OpdKind::None: return "";
+            case OpdKind::Imm: return std::to_string(imm());
+            default: return interner.str(m_value);
+        }
+    }
+};
 
 struct EmitTacResult {
-    std::string m_temp;
-    Type m_type;
+    Operand m_temp;
+    TypeId m_type;
 };
 
 
-enum class TacT {
-    EmptyQuad,
+enum class TacT: uint8_t {
     Plus,
     Minus,
     Star,
@@ -35,27 +76,69 @@ enum class TacT {
     Return
 };
 
+/*
+ * One three-address instruction, packed into 16 bytes with no owned memory.
+ * The operand kinds and values are stored apart so the quad doesn't pad out to 28 bytes.
+ *
+ * Arithmetic, compare, Assign: m_target = opd1 op opd2 (Assign only uses opd1)
+ * CondGoto:   target is the condition, opd1 the label taken when it is false, opd2 the label taken
+ *             when it is true (none once it falls through)
+ * Goto:       opd2 label
+ * FunBegin:   opd2 frame size in bytes
+ * PushArg:    opd2 argument
+ * PopArgs:    opd2 bytes to pop
+ * CallNil:    opd2 function
+ * CallResult: target = result of calling function opd2
+ * Return:     opd2 value
+ */
 class TacQuad {
     public:
+        static constexpr int TARGET = 0;
+        static constexpr int OPD1 = 1;
+        static constexpr int OPD2 = 2;
     public:
-        std::string m_target;
-        std::string m_opd1;
-        std::string m_opd2;
         enum TacT m_op;
-        static int s_label_counter;
+        OpdKind m_kinds[3];
+        uint32_t m_values[3];
     public:
+        TacQuad(Operand target, Operand opd1, Operand opd2, enum TacT op):
+            m_op(op), m_kinds{target.m_kind, opd1.m_kind, opd2.m_kind}, m_values{target.m_value, opd1.m_value, opd2.m_value} {}
 
-        static std::string new_label() {
-            return "_L" + std::to_string(s_label_counter++);
+        Operand opd(int i) const {
+            return {m_kinds[i], m_values[i]};
+        }
+        void set_opd(int i, Operand o) {
+            m_kinds[i] = o.m_kind;
+            m_values[i] = o.m_value;
+        }
+        Operand target() const { return opd(TARGET); }
+        Operand opd1() const { return opd(OPD1); }
+        Operand opd2() const { return opd(OPD2); }
+        void set_target(Operand o) { set_opd(TARGET, o); }
+        void set_opd1(Operand o) { set_opd(OPD1, o); }
+        void set_opd2(Operand o) { set_opd(OPD2, o); }
+        //whether target() is written - CondGoto reads its condition from there instead
+        bool defines_target() const {
+            switch (m_op) {
+                case TacT::Plus:
+                case TacT::Minus:
+                case TacT::Star:
+                case TacT::Slash:
+                case TacT::Assign:
+                case TacT::EqualEqual:
+                case TacT::Less:
+                case TacT::Or:
+                case TacT::And:
+                case TacT::CallResult:
+                    return true;
+                default:
+                    return false;
+            }
         }
-        TacQuad(const std::string& target, const std::string& opd1, const std::string& opd2, enum TacT op):
-            m_target(target), m_opd1(opd1), m_opd2(opd2), m_op(op) {}
 
-        
         std::string to_string() const {
             std::string ret;
             switch (m_op) {
-                case TacT::EmptyQuad: ret = "EmptyQuad"; break;
                 case TacT::Plus: ret = "Plus"; break;
                 case TacT::Minus: ret = "Minus"; break;
                 case TacT::Star: ret = "Star"; break;
@@ -79,21 +162,62 @@ class TacQuad {
                 default: ret = "<Unrecognized TacT>"; break;
             }
 
-            ret += ", " + m_target + ", " + m_opd1 + ", " + m_opd2;
+            ret += ", " + target().to_string() + ", " + opd1().to_string() + ", " + opd2().to_string();
             return ret;
         }
+};
 
-    static void print_tac(const std::vector<TacQuad>& quads, const std::vector<std::string>& tac_labels) {
-        for (int i = 0; i < quads.size(); i++) {
-            const TacQuad& q = quads[i];
-            const std::string& str = tac_labels[i];
-            if (str != "") {
-                std::cout << str << ":" << std::endl;
-            }
-            std::cout << "    " << q.to_string() << std::endl;
-        }
-    }
+static_assert(sizeof(TacQuad) == 16, "TacQuad should stay a 16-byte POD");
+static_assert(std::is_trivially_copyable<TacQuad>::value, "TacQuad should stay a 16-byte POD");
+
+typedef uint32_t InstrId;
+typedef uint32_t BlockId;
+static constexpr InstrId INSTR_NONE = UINT32_MAX;
+static constexpr BlockId BLOCK_NONE = UINT32_MAX;
+
+//an instruction linked into its block's list by index into TacFunction::m_instrs
+struct TacInstr {
+    TacQuad m_quad;
+    InstrId m_prev;
+    InstrId m_next;
+};
 
+struct TacBlock {
+    SymbolId m_label;
+    InstrId m_first = INSTR_NONE;
+    InstrId m_last = INSTR_NONE;
 };
 
+/*
+ * One function, or the entry code ahead of the first function, as a list of labelled blocks.
+ * Instructions live in m_instrs and are threaded into their block by index, so passes insert and
+ * remove them in O(1). Removed instructions are unlinked, not reused.
+ * Functions share nothing but the interner, so they can be optimized and lowered independently.
+ */
+class TacFunction {
+    public:
+        SymbolId m_name;
+        std::vector<TacBlock> m_blocks; //in layout order; the first is labelled m_name
+        std::vector<TacInstr> m_instrs;
+        std::unordered_map<SymbolId, BlockId> m_labels;
+    public:
+        explicit TacFunction(SymbolId name): m_name(name) {}
+        BlockId add_block(SymbolId label);
+        BlockId insert_block(BlockId pos, SymbolId label);
+        InstrId append(BlockId block, const TacQuad& q);
+        InstrId insert_before(BlockId block, InstrId pos, const TacQuad& q);
+        void remove(BlockId block, InstrId id);
+        void remove_blocks(const std::vector<bool>& dead);
+        BlockId block_of(SymbolId label) const {
+            std::unordered_map<SymbolId, BlockId>::const_iterator it = m_labels.find(label);
+            return it == m_labels.end() ? BLOCK_NONE : it->second;
+        }
+        TacQuad& quad(InstrId id) { return m_instrs[id].m_quad; }
+        const TacQuad& quad(InstrId id) const { return m_instrs[id].m_quad; }
+        InstrId next(InstrId id) const { return m_instrs[id].m_next; }
+        bool falls_through(BlockId block) const;
+};
+
+void print_tac(const std::vector<TacFunction>& functions);
+
 #endif //TAC_HPP
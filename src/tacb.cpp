@@ -0,0 +1,290 @@
+#include <fstream>
+#include <algorithm>
+#include <unordered_set>
+
+#include "tacb.hpp"
+
+/*
+ * Builds the string and type tables while the sections are collected.
+ */
+class TacbWriter {
+    public:
+        std::vector<uint32_t> m_string_offsets {0};
+        std::string m_strings;
+        std::vector<TacbType> m_types;
+        std::vector<uint32_t> m_params;
+        std::vector<TacbFunction> m_functions;
+        std::vector<TacbBlock> m_blocks;
+        std::vector<TacQuad> m_quads;
+        std::vector<TacbSymbol> m_symbols;
+    private:
+        std::unordered_map<SymbolId, uint32_t> m_string_ids;
+        std::unordered_map<TypeId, uint32_t> m_type_ids;
+    public:
+        uint32_t string_id(SymbolId name) {
+            std::unordered_map<SymbolId, uint32_t>::iterator it = m_string_ids.find(name);
+            if (it != m_string_ids.end()) return it->second;
+
+            uint32_t id = m_string_offsets.size() - 1;
+            m_strings.append(interner.view(name));
+            m_strings.push_back('\0');
+            m_string_offsets.push_back(m_strings.size());
+            m_string_ids.insert({name, id});
+            return id;
+        }
+
+        //parameter and return types are added first, so readers can intern the table front to back
+        uint32_t type_id(TypeId type) {
+            std::unordered_map<TypeId, uint32_t>::iterator it = m_type_ids.find(type);
+            if (it != m_type_ids.end()) return it->second;
+
+            TypeInfo info = types.info(type);
+            TacbType t = {(uint32_t)info.m_dtype, TACB_NONE, 0, info.m_param_count};
+            std::vector<uint32_t> params;
+            if (info.m_dtype == T_FUN_TYPE) {
+                t.m_rtype = type_id(info.m_rtype);
+                for (uint32_t i = 0; i < info.m_param_count; i++) {
+                    params.push_back(type_id(types.param(type, i)));
+                }
+            }
+            t.m_first_param = m_params.size();
+            m_params.insert(m_params.end(), params.begin(), params.end());
+
+            uint32_t id = m_types.size();
+            m_types.push_back(t);
+            m_type_ids.insert({type, id});
+            return id;
+        }
+
+        Operand operand(Operand o) {
+            if (o.m_kind == OpdKind::Var || o.m_kind == OpdKind::Label || o.m_kind == OpdKind::Fun) {
+                o.m_value = string_id(o.m_value);
+            }
+            return o;
+        }
+
+        void add_function(const TacFunction& fn, const X86Frame* frame) {
+            TacbFunction f = {string_id(fn.m_name), (uint32_t)m_blocks.size(), (uint32_t)fn.m_blocks.size(), TACB_NONE, 0};
+            for (const TacBlock& b: fn.m_blocks) {
+                TacbBlock tb = {string_id(b.m_label), (uint32_t)m_quads.size(), 0};
+                for (InstrId i = b.m_first; i != INSTR_NONE; i = fn.next(i)) {
+                    const TacQuad& q = fn.quad(i);
+                    m_quads.push_back(TacQuad(operand(q.target()), operand(q.opd1()), operand(q.opd2()), q.m_op));
+                    tb.m_quad_count++;
+                }
+                m_blocks.push_back(tb);
+            }
+
+            if (frame) {
+                //frames are hash maps, so symbols are sorted to keep the file the same from build to build
+                std::vector<std::pair<SymbolId, const Symbol*>> symbols;
+                for (const std::pair<const SymbolId, Symbol>& p: frame->m_symbols) {
+                    symbols.push_back({p.first, &p.second});
+                }
+                std::sort(symbols.begin(), symbols.end(), [](const auto& a, const auto& b) { return interner.view(a.first) < interner.view(b.first); });
+
+                f.m_first_symbol = m_symbols.size();
+                f.m_symbol_count = symbols.size();
+                for (const std::pair<SymbolId, const Symbol*>& p: symbols) {
+                    const Symbol* sym = p.second;
+                    m_symbols.push_back({string_id(p.first), string_id(sym->m_name), string_id(sym->m_tac_name),
+                                         type_id(sym->m_type), sym->m_fp_offset});
+                }
+            }
+            m_functions.push_back(f);
+        }
+};
+
+template <typename T>
+static void put_array(std::string& out, const std::vector<T>& v) {
+    out.append((const char*)v.data(), v.size() * sizeof(T));
+}
+
+static size_t align4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+bool write_tacb(const std::string& path, const std::vector<TacFunction>& functions, const std::unordered_map<SymbolId, X86Frame>& frames) {
+    TacbWriter w;
+    for (const TacFunction& fn: functions) {
+        std::unordered_map<SymbolId, X86Frame>::const_iterator it = frames.find(fn.m_name);
+        w.add_function(fn, it == frames.end() ? nullptr : &it->second);
+    }
+
+    TacbHeader h;
+    std::copy(TACB_MAGIC, TACB_MAGIC + sizeof(TACB_MAGIC), h.m_magic);
+    h.m_version = TACB_VERSION;
+    h.m_string_count = w.m_string_offsets.size() - 1;
+    h.m_string_bytes = w.m_strings.size();
+    h.m_type_count = w.m_types.size();
+    h.m_param_count = w.m_params.size();
+    h.m_function_count = w.m_functions.size();
+    h.m_block_count = w.m_blocks.size();
+    h.m_quad_count = w.m_quads.size();
+    h.m_symbol_count = w.m_symbols.size();
+
+    std::string out((const char*)&h, sizeof(h));
+    put_array(out, w.m_string_offsets);
+    out.append(w.m_strings);
+    out.resize(align4(out.size()), '\0');
+    put_array(out, w.m_types);
+    put_array(out, w.m_params);
+    put_array(out, w.m_functions);
+    put_array(out, w.m_blocks);
+    put_array(out, w.m_quads);
+    put_array(out, w.m_symbols);
+
+    std::ofstream f(path, std::ios::out | std::ios::binary);
+    f.write(out.data(), out.size());
+    return (bool)f;
+}
+
+//fails on a missing, truncated or malformed file, or one written by another version
+bool TacbFile::open(const std::string& path) {
+    m_header = nullptr;
+    if (!m_map.open(path)) return false;
+
+    std::string_view data = m_map.view();
+    if (data.size() < sizeof(TacbHeader)) return false;
+    const TacbHeader* h = (const TacbHeader*)data.data();
+    if (!std::equal(TACB_MAGIC, TACB_MAGIC + sizeof(TACB_MAGIC), h->m_magic) || h->m_version != TACB_VERSION) return false;
+
+    //sizes are summed in 64 bits so huge counts can't wrap around to the file size
+    uint64_t offset = sizeof(TacbHeader);
+    auto section = [&](uint64_t count, size_t size) {
+        const char* p = data.data() + std::min<uint64_t>(offset, data.size());
+        offset += count * size;
+        return p;
+    };
+    m_string_offsets = (const uint32_t*)section((uint64_t)h->m_string_count + 1, sizeof(uint32_t));
+    m_strings = section(align4(h->m_string_bytes), 1);
+    m_types = (const TacbType*)section(h->m_type_count, sizeof(TacbType));
+    m_params = (const uint32_t*)section(h->m_param_count, sizeof(uint32_t));
+    m_functions = (const TacbFunction*)section(h->m_function_count, sizeof(TacbFunction));
+    m_blocks = (const TacbBlock*)section(h->m_block_count, sizeof(TacbBlock));
+    m_quads = (const TacQuad*)section(h->m_quad_count, sizeof(TacQuad));
+    m_symbols = (const TacbSymbol*)section(h->m_symbol_count, sizeof(TacbSymbol));
+    if (offset != data.size()) return false;
+
+    m_header = h;
+    if (!validate()) {
+        m_header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+static bool in_range(uint32_t first, uint32_t count, uint32_t size) {
+    return (uint64_t)first + count <= size;
+}
+
+bool TacbFile::validate() const {
+    const TacbHeader& h = *m_header;
+
+    if (m_string_offsets[0] != 0 || m_string_offsets[h.m_string_count] != h.m_string_bytes) return false;
+    for (uint32_t i = 0; i < h.m_string_count; i++) {
+        uint32_t end = m_string_offsets[i + 1];
+        if (end <= m_string_offsets[i] || end > h.m_string_bytes || m_strings[end - 1] != '\0') return false;
+    }
+
+    for (uint32_t i = 0; i < h.m_type_count; i++) {
+        const TacbType& t = m_types[i];
+        if (t.m_dtype >= T_TOKEN_COUNT || !in_range(t.m_first_param, t.m_param_count, h.m_param_count)) return false;
+        if (t.m_rtype != TACB_NONE && t.m_rtype >= i) return false;
+        for (uint32_t j = 0; j < t.m_param_count; j++) {
+            if (m_params[t.m_first_param + j] >= i) return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < h.m_function_count; i++) {
+        const TacbFunction& f = m_functions[i];
+        if (f.m_name >= h.m_string_count || !in_range(f.m_first_block, f.m_block_count, h.m_block_count)) return false;
+        if (f.m_first_symbol == TACB_NONE ? f.m_symbol_count != 0 : !in_range(f.m_first_symbol, f.m_symbol_count, h.m_symbol_count)) return false;
+    }
+
+    for (uint32_t i = 0; i < h.m_block_count; i++) {
+        const TacbBlock& b = m_blocks[i];
+        if (b.m_label >= h.m_string_count || !in_range(b.m_first_quad, b.m_quad_count, h.m_quad_count)) return false;
+    }
+
+    for (uint32_t i = 0; i < h.m_quad_count; i++) {
+        const TacQuad& q = m_quads[i];
+        if (q.m_op > TacT::Return) return false;
+        for (int j = 0; j < 3; j++) {
+            OpdKind k = q.m_kinds[j];
+            if (k > OpdKind::Fun) return false;
+            if ((k == OpdKind::Var || k == OpdKind::Label || k == OpdKind::Fun) && q.m_values[j] >= h.m_string_count) return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < h.m_symbol_count; i++) {
+        const TacbSymbol& s = m_symbols[i];
+        if (s.m_key >= h.m_string_count || s.m_name >= h.m_string_count || s.m_tac_name >= h.m_string_count || s.m_type >= h.m_type_count) return false;
+    }
+
+    //the code generator looks every variable up in its function's frame
+    for (uint32_t i = 0; i < h.m_function_count; i++) {
+        const TacbFunction& f = m_functions[i];
+        std::unordered_set<uint32_t> keys;
+        for (uint32_t j = 0; j < f.m_symbol_count; j++) {
+            keys.insert(m_symbols[f.m_first_symbol + j].m_key);
+        }
+        for (uint32_t j = 0; j < f.m_block_count; j++) {
+            const TacbBlock& b = m_blocks[f.m_first_block + j];
+            for (uint32_t k = 0; k < b.m_quad_count; k++) {
+                const TacQuad& q = m_quads[b.m_first_quad + k];
+                if (q.m_op == TacT::FunBegin && f.m_first_symbol == TACB_NONE) return false;
+                for (int o = 0; o < 3; o++) {
+                    if (q.m_kinds[o] == OpdKind::Var && keys.find(q.m_values[o]) == keys.end()) return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void TacbFile::load(std::vector<TacFunction>* functions, std::unordered_map<SymbolId, X86Frame>* frames) const {
+    const TacbHeader& h = *m_header;
+
+    std::vector<SymbolId> names(h.m_string_count);
+    for (uint32_t i = 0; i < h.m_string_count; i++) {
+        names[i] = interner.intern(string(i));
+    }
+
+    std::vector<TypeId> tids(h.m_type_count);
+    for (uint32_t i = 0; i < h.m_type_count; i++) {
+        const TacbType& t = m_types[i];
+        std::vector<TypeId> params;
+        for (uint32_t j = 0; j < t.m_param_count; j++) {
+            params.push_back(tids[m_params[t.m_first_param + j]]);
+        }
+        tids[i] = types.intern((enum TokenType)t.m_dtype, t.m_rtype == TACB_NONE ? TypeTable::NIL : tids[t.m_rtype], params);
+    }
+
+    for (uint32_t i = 0; i < h.m_function_count; i++) {
+        const TacbFunction& f = m_functions[i];
+        TacFunction fn(names[f.m_name]);
+        for (uint32_t j = 0; j < f.m_block_count; j++) {
+            const TacbBlock& tb = m_blocks[f.m_first_block + j];
+            BlockId b = fn.add_block(names[tb.m_label]);
+            for (uint32_t k = 0; k < tb.m_quad_count; k++) {
+                TacQuad q = m_quads[tb.m_first_quad + k];
+                for (int o = 0; o < 3; o++) {
+                    if (q.m_kinds[o] == OpdKind::Var || q.m_kinds[o] == OpdKind::Label || q.m_kinds[o] == OpdKind::Fun) {
+                        q.m_values[o] = names[q.m_values[o]];
+                    }
+                }
+                fn.append(b, q);
+            }
+        }
+        functions->push_back(std::move(fn));
+
+        if (f.m_first_symbol == TACB_NONE) continue;
+        X86Frame& frame = (*frames)[names[f.m_name]];
+        for (uint32_t j = 0; j < f.m_symbol_count; j++) {
+            const TacbSymbol& s = m_symbols[f.m_first_symbol + j];
+            frame.m_symbols.insert({names[s.m_key], Symbol(names[s.m_name], names[s.m_tac_name], tids[s.m_type], s.m_fp_offset)});
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef TACB_HPP
+#define TACB_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "tac.hpp"
+#include "x86_frame.hpp"
+#include "source_buffer.hpp"
+
+/*
+ * .tacb: a module's TAC, label table, frame layouts and types, laid out so a mapped file can be used in place.
+ *
+ * Layout (host byte order, every section 4-byte aligned):
+ *  TacbHeader
+ *  u32 string offsets[string count + 1], then the NUL-terminated string bytes, padded to 4
+ *  TacbType types[type count], u32 parameter types[param count]
+ *  TacbFunction functions[function count]
+ *  TacbBlock blocks[block count]
+ *  TacQuad quads[quad count] - in block order; Var, Label and Fun operands hold string indices
+ *  TacbSymbol symbols[symbol count]
+ *
+ * Names are stored as indices into the file's string table and types as indices into its type table,
+ * since SymbolIds and TypeIds are only meaningful within one build.
+ * The quads are raw TacQuads, so any change to TacQuad, TacT or OpdKind must bump TACB_VERSION.
+ */
+static constexpr char TACB_MAGIC[4] = {'T', 'A', 'C', 'B'};
+static constexpr uint32_t TACB_VERSION = 1;
+static constexpr uint32_t TACB_NONE = UINT32_MAX;
+
+struct TacbHeader {
+    char m_magic[4];
+    uint32_t m_version;
+    uint32_t m_string_count;
+    uint32_t m_string_bytes;
+    uint32_t m_type_count;
+    uint32_t m_param_count;
+    uint32_t m_function_count;
+    uint32_t m_block_count;
+    uint32_t m_quad_count;
+    uint32_t m_symbol_count;
+};
+
+//types only refer to types ahead of them in the table
+struct TacbType {
+    uint32_t m_dtype;
+    uint32_t m_rtype; //TACB_NONE unless a function type
+    uint32_t m_first_param;
+    uint32_t m_param_count;
+};
+
+struct TacbFunction {
+    uint32_t m_name;
+    uint32_t m_first_block;
+    uint32_t m_block_count;
+    uint32_t m_first_symbol; //the function's frame, TACB_NONE if it has none
+    uint32_t m_symbol_count;
+};
+
+struct TacbBlock {
+    uint32_t m_label;
+    uint32_t m_first_quad;
+    uint32_t m_quad_count;
+};
+
+//one X86Frame entry, m_key being the name the frame is searched by
+struct TacbSymbol {
+    uint32_t m_key;
+    uint32_t m_name;
+    uint32_t m_tac_name;
+    uint32_t m_type;
+    int32_t m_fp_offset;
+};
+
+bool write_tacb(const std::string& path, const std::vector<TacFunction>& functions, const std::unordered_map<SymbolId, X86Frame>& frames);
+
+/*
+ * Read-only view of a mapped .tacb file.
+ * open() checks the whole file once - sizes, ranges and every index - so the accessors never need to.
+ */
+class TacbFile {
+    private:
+        SourceBuffer m_map;
+        const TacbHeader* m_header = nullptr;
+        const uint32_t* m_string_offsets = nullptr;
+        const char* m_strings = nullptr;
+        const TacbType* m_types = nullptr;
+        const uint32_t* m_params = nullptr;
+        const TacbFunction* m_functions = nullptr;
+        const TacbBlock* m_blocks = nullptr;
+        const TacQuad* m_quads = nullptr;
+        const TacbSymbol* m_symbols = nullptr;
+    public:
+        bool open(const std::string& path);
+        const TacbHeader& header() const { return *m_header; }
+        std::string_view string(uint32_t i) const {
+            return std::string_view(m_strings + m_string_offsets[i], m_string_offsets[i + 1] - m_string_offsets[i] - 1);
+        }
+        const TacbType& type(uint32_t i) const { return m_types[i]; }
+        uint32_t param(uint32_t i) const { return m_params[i]; }
+        const TacbFunction& function(uint32_t i) const { return m_functions[i]; }
+        const TacbBlock& block(uint32_t i) const { return m_blocks[i]; }
+        const TacQuad& quad(uint32_t i) const { return m_quads[i]; }
+        const TacbSymbol& symbol(uint32_t i) const { return m_symbols[i]; }
+        //interns the file's names and types and rebuilds the module's functions and frames
+        void load(std::vector<TacFunction>* functions, std::unordered_map<SymbolId, X86Frame>* frames) const;
+    private:
+        bool validate() const;
+};
+
+#endif //TACB_HPP
@@ -0,0 +1,121 @@
+#include "thread_pool.hpp"
+
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local int t_slot = 0;
+
+ThreadPool::ThreadPool(int threads): m_queued(0) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    t_pool = this;
+    t_slot = 0;
+    for (int i = 1; i < threads; i++) {
+        m_threads.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& t: m_threads) {
+        t.join();
+    }
+}
+
+//threads outside the pool share the creating thread's deque
+int ThreadPool::current_slot() const {
+    return t_pool == this ? t_slot : 0;
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& job) {
+    if (m_workers.size() == 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    int slot = current_slot();
+    std::atomic<size_t> pending(count);
+    {
+        //counted before they are pushed, so a thief never takes a task m_queued doesn't know about yet
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_queued += count;
+    }
+    {
+        //pushed in reverse so the owner pops jobs in order while thieves take the far end
+        std::lock_guard<std::mutex> lock(m_workers[slot]->m_mutex);
+        for (size_t i = count; i-- > 0;) {
+            m_workers[slot]->m_tasks.push_back({&job, i, &pending});
+        }
+    }
+    m_wake.notify_all();
+
+    //help out until every job of this batch has finished, possibly on other threads
+    Task task;
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (pop_task(slot, &task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake.wait(lock, [&]() { return pending.load(std::memory_order_acquire) == 0 || m_queued > 0; });
+    }
+}
+
+bool ThreadPool::pop_task(int slot, Task* task) {
+    {
+        Worker& own = *m_workers[slot];
+        std::lock_guard<std::mutex> lock(own.m_mutex);
+        if (!own.m_tasks.empty()) {
+            *task = own.m_tasks.back();
+            own.m_tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_workers.size(); i++) {
+        Worker& victim = *m_workers[(slot + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.m_mutex);
+        if (!victim.m_tasks.empty()) {
+            *task = victim.m_tasks.front();
+            victim.m_tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+//whoever finishes a batch wakes its caller, which may be asleep in run()
+void ThreadPool::execute(const Task& task) {
+    (*task.m_job)(task.m_index);
+    if (task.m_pending->fetch_sub(1, std::memory_order_release) == 1) {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_wake.notify_all();
+    }
+}
+
+void ThreadPool::work(int slot) {
+    t_pool = this;
+    t_slot = slot;
+
+    Task task;
+    while (true) {
+        if (pop_task(slot, &task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake.wait(lock, [&]() { return m_stop || m_queued > 0; });
+        if (m_stop && m_queued == 0) return;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing pool for fork-join jobs. Every thread owns a deque of tasks: it pushes and pops
+ * its own tasks at the back and steals from the front of other threads' deques when it runs dry.
+ * run() may be called from inside a job (modules fan out into functions). The calling thread
+ * runs queued tasks, its own or stolen, until its batch is done, and only sleeps while nothing is
+ * queued and the rest of its batch is still running on other threads.
+ * Jobs must not touch each other's state - results are written to per-job slots
+ * and merged by the caller in job order once run() returns.
+ */
+class ThreadPool {
+    private:
+        struct Task {
+            const std::function<void(size_t)>* m_job;
+            size_t m_index;
+            std::atomic<size_t>* m_pending;
+        };
+
+        struct Worker {
+            std::mutex m_mutex;
+            std::deque<Task> m_tasks;
+        };
+    private:
+        std::vector<std::unique_ptr<Worker>> m_workers; //slot 0 belongs to the thread that created the pool
+        std::vector<std::thread> m_threads;
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_wake; //signalled when tasks are queued or a batch finishes
+        std::atomic<size_t> m_queued;
+        bool m_stop = false;
+    public:
+        ThreadPool(int threads);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        void run(size_t count, const std::function<void(size_t)>& job);
+        size_t size() const {
+            return m_workers.size();
+        }
+    private:
+        int current_slot() const;
+        bool pop_task(int slot, Task* task);
+        void execute(const Task& task);
+        void work(int slot);
+};
+
+#endif //THREAD_POOL_HPP
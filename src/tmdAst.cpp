@@ -0,0 +1,444 @@
+#include <cstdlib>
+
+#include "semant.hpp"
+#include "x86_frame.hpp"
+#include "symbol.hpp"
+
+/*
+ * IR emission for each Tamarind node kind
+ */
+
+EmitTacResult Semant::emit_ir(AstId id) {
+    const AstNode& n = m_tree[id];
+    switch (n.m_kind) {
+        case AstKind::Binary:   return emit_binary(n);
+        case AstKind::Unary:    return emit_unary(n);
+        case AstKind::Literal:  return emit_literal(n);
+        case AstKind::Print:    return emit_print(n);
+        case AstKind::ExprStmt: emit_ir(n.m_a); return {Operand::none(), TypeTable::NIL};
+        case AstKind::Param:    return {Operand::none(), types.primitive((enum TokenType)n.m_aux)}; //NOTE: parameters should NOT emit any code
+        case AstKind::FunDef:   return emit_fun_def(id);
+        case AstKind::DeclSym:  return emit_decl_sym(n);
+        case AstKind::GetSym:   return emit_get_sym(n);
+        case AstKind::SetSym:   return emit_set_sym(n);
+        case AstKind::Block:    return emit_block(n);
+        case AstKind::If:       return emit_if(n);
+        case AstKind::While:    return emit_while(n);
+        case AstKind::Call:     return emit_call(n);
+        case AstKind::Return:   return emit_return(n);
+        case AstKind::Import:   return emit_import(n);
+    }
+    return {Operand::none(), TypeTable::NIL};
+}
+
+//index of the formal parameter of the function being compiled named by symbol, or -1
+int Semant::find_param(SymbolId symbol) {
+    const AstNode& f = m_tree[m_compiling_fun];
+    const AstId* params = m_tree.list(f.m_a);
+    for (uint32_t i = 0; i < f.m_b; i++) {
+        if (m_tree[params[i]].m_sym == symbol) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+EmitTacResult Semant::emit_binary(const AstNode& n) {
+    struct Token op = n.m_t;
+    TypeId ret_type = TypeTable::NIL;
+    EmitTacResult left_result = emit_ir(n.m_a);
+    EmitTacResult right_result = emit_ir(n.m_b);
+
+    if (left_result.m_type != right_result.m_type) {
+        m_ems.add_error(m_source.line(op), "Type Error: Left and right types don't match!");
+    } else if (op.type == T_PLUS || op.type == T_MINUS || op.type == T_SLASH || op.type == T_STAR) {
+        ret_type = TypeTable::INT;
+    } else {
+        ret_type = TypeTable::BOOL;
+    }
+
+    Operand t = Operand::var(get_compiling_frame()->add_temp(ret_type));
+    switch (op.type) {
+        case T_PLUS:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::Plus));
+            break;
+        case T_MINUS:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::Minus));
+            break;
+        case T_STAR:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::Star));
+            break;
+        case T_SLASH:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::Slash));
+            break;
+        case T_LESS:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::Less));
+            break;
+        case T_EQUAL_EQUAL:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::EqualEqual));
+            break;
+        case T_AND:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::And));
+            break;
+        case T_OR:
+            emit(TacQuad(t, left_result.m_temp, right_result.m_temp, TacT::Or));
+            break;
+        //synthesize these other operators
+        case T_GREATER: {
+            emit(TacQuad(t, right_result.m_temp, left_result.m_temp, TacT::Less));
+            break;
+        }
+        case T_LESS_EQUAL: {
+            Operand tl = Operand::var(get_compiling_frame()->add_temp(ret_type));
+            emit(TacQuad(tl, left_result.m_temp, right_result.m_temp, TacT::Less));
+            Operand te = Operand::var(get_compiling_frame()->add_temp(ret_type));
+            emit(TacQuad(te, left_result.m_temp, right_result.m_temp, TacT::EqualEqual));
+            emit(TacQuad(t, tl, te, TacT::Or));
+            break;
+        }
+        case T_GREATER_EQUAL: {
+            Operand tg = Operand::var(get_compiling_frame()->add_temp(ret_type));
+            emit(TacQuad(tg, right_result.m_temp, left_result.m_temp, TacT::Less));
+            Operand te = Operand::var(get_compiling_frame()->add_temp(ret_type));
+            emit(TacQuad(te, left_result.m_temp, right_result.m_temp, TacT::EqualEqual));
+            emit(TacQuad(t, tg, te, TacT::Or));
+            break;
+        }
+        case T_NOT_EQUAL: {
+            Operand tl = Operand::var(get_compiling_frame()->add_temp(ret_type));
+            emit(TacQuad(tl, left_result.m_temp, right_result.m_temp, TacT::Less));
+            Operand tg = Operand::var(get_compiling_frame()->add_temp(ret_type));
+            emit(TacQuad(tg, right_result.m_temp, left_result.m_temp, TacT::Less));
+            emit(TacQuad(t, tl, tg, TacT::Or));
+            break;
+        }
+        default:
+            m_ems.add_error(m_source.line(op), "Translate Error: Binary operator not recognized.");
+            break;
+    }
+
+    return {t, ret_type};
+}
+
+EmitTacResult Semant::emit_unary(const AstNode& n) {
+    EmitTacResult r = emit_ir(n.m_a);
+
+    Operand t = Operand::var(get_compiling_frame()->add_temp(r.m_type));
+    if (r.m_type == TypeTable::INT) {
+        emit(TacQuad(t, Operand::imm(0), r.m_temp, TacT::Minus));
+    } else if (r.m_type == TypeTable::BOOL) {
+        Operand tl = Operand::var(get_compiling_frame()->add_temp(r.m_type));
+        emit(TacQuad(tl, r.m_temp, Operand::imm(1), TacT::Less));
+        Operand tg = Operand::var(get_compiling_frame()->add_temp(r.m_type));
+        emit(TacQuad(tg, Operand::imm(1), r.m_temp, TacT::Less));
+        emit(TacQuad(t, tl, tg, TacT::Or));
+    } else {
+        m_ems.add_error(m_source.line(n.m_t), "Unary expression does not support that operator.");
+    }
+    return {t, r.m_type};
+}
+
+EmitTacResult Semant::emit_literal(const AstNode& n) {
+    struct Token lexeme = n.m_t;
+    Operand t = Operand::none();
+    if (lexeme.type == T_INT) {
+        t = Operand::imm((int32_t)strtol(m_source.str(lexeme).c_str(), nullptr, 10));
+    } else if (lexeme.type == T_TRUE) {
+        t = Operand::imm(1);
+    } else if (lexeme.type == T_FALSE) {
+        t = Operand::imm(0);
+    } else if (lexeme.type == T_NIL) {
+        t = Operand::imm(0);
+    } else {
+        m_ems.add_error(m_source.line(lexeme), "Synax Error: Invalid literal");
+    }
+
+    TypeId type = TypeTable::NIL;
+    switch (lexeme.type) {
+        case T_INT:
+            type =  TypeTable::INT;
+            break;
+        case T_TRUE:
+        case T_FALSE:
+            type = TypeTable::BOOL;
+            break;
+        default:
+            break;
+    }
+
+    return {t, type};
+}
+
+//TODO: should generalize to use AstKind::Call
+EmitTacResult Semant::emit_print(const AstNode& n) {
+    EmitTacResult r = emit_ir(n.m_a);
+
+    emit(TacQuad(Operand::none(), Operand::none(), r.m_temp, TacT::PushArg));
+    if (r.m_type == TypeTable::INT) {
+        emit(TacQuad(Operand::none(), Operand::none(), Operand::fun(interner.intern("_print_int")), TacT::CallNil));
+    } else if (r.m_type == TypeTable::BOOL) {
+        emit(TacQuad(Operand::none(), Operand::none(), Operand::fun(interner.intern("_print_bool")), TacT::CallNil));
+    } else {
+        //TODO: error message with line info goes here
+    }
+    emit(TacQuad(Operand::none(), Operand::none(), Operand::imm(4), TacT::PopArgs));
+
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_fun_def(AstId id) {
+    const AstNode& n = m_tree[id];
+    m_frames->insert({n.m_sym, X86Frame()});
+
+    std::unordered_map<SymbolId, X86Frame>::iterator it = m_frames->find(n.m_sym);
+    std::vector<TypeId> ptypes = std::vector<TypeId>();
+    int ord_num = 0;
+
+    const AstId* params = m_tree.list(n.m_a);
+    for (uint32_t i = 0; i < n.m_b; i++) {
+        EmitTacResult r = emit_ir(params[i]);
+        ptypes.push_back(r.m_type); //NOTE: parameters should NOT emit any code
+        it->second.add_parameter_to_frame(m_tree[params[i]].m_sym, r.m_type, ord_num);
+        ord_num++;
+    }
+
+    if (m_globals.m_symbols.find(n.m_sym) != m_globals.m_symbols.end()) {
+        m_ems.add_error(m_source.line(n.m_t), "Syntax Error: Function with name already declared in global scope.");
+    } else {
+        m_globals.m_symbols.insert({n.m_sym, Symbol(n.m_sym, Interner::EMPTY, types.function(types.primitive((enum TokenType)n.m_aux), ptypes), 0)});
+    }
+
+    begin_function(n.m_sym);
+    size_t fun = m_functions.size() - 1;
+    InstrId begin = emit(TacQuad(Operand::none(), Operand::none(), Operand::none(), TacT::FunBegin));
+    int start_temps = it->second.m_temp_counter;
+
+    m_compiling_fun = id;
+    emit_ir(n.m_c);
+    m_compiling_fun = AST_NONE;
+
+    int reserved_stack_variables = it->second.m_temp_counter - start_temps;
+    m_functions[fun].quad(begin).set_opd2(Operand::imm(reserved_stack_variables * 4));
+    emit(TacQuad(Operand::none(), Operand::none(), Operand::none(), TacT::FunEnd));
+
+
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_decl_sym(const AstNode& n) {
+    struct Token symbol = n.m_t;
+    if (find_param(n.m_sym) != -1) {
+        m_ems.add_error(m_source.line(symbol), "Syntax Error: Formal parameter already declared using symbol");
+    }
+
+    EmitTacResult r = emit_ir(n.m_a);
+
+    if (r.m_type != types.primitive((enum TokenType)n.m_aux)) {
+        m_ems.add_error(m_source.line(symbol), "Type Error: Declaration type and assigned value type don't match!");
+    }
+
+    if(get_compiling_frame()->symbol_defined_in_current_scope(n.m_sym)) {
+        m_ems.add_error(m_source.line(symbol), "Syntax Error: Local symbol already declared in this scope!");
+    }
+
+    Operand local_temp = Operand::var(get_compiling_frame()->add_local(n.m_sym, r.m_type));
+
+    emit(TacQuad(local_temp, r.m_temp, Operand::none(), TacT::Assign));
+
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_get_sym(const AstNode& n) {
+    struct Token symbol = n.m_t;
+    int arg_offset = find_param(n.m_sym);
+
+    if (arg_offset == -1) { //symbol is local
+        Symbol* sym = get_compiling_frame()->get_symbol_from_scopes(n.m_sym);
+
+        if (!sym) {
+            m_ems.add_error(m_source.line(symbol), "Syntax Error: Variable not declared!");
+            return {Operand::none(), TypeTable::NIL};
+        }
+
+        return {Operand::var(sym->m_tac_name), sym->m_type};
+    } else { //symbol is formal parameter
+        const AstNode& p = m_tree[m_tree.list(m_tree[m_compiling_fun].m_a)[arg_offset]];
+        return {Operand::var(p.m_sym), types.primitive((enum TokenType)p.m_aux)};
+    }
+}
+
+EmitTacResult Semant::emit_set_sym(const AstNode& n) {
+    struct Token symbol = n.m_t;
+    int arg_offset = find_param(n.m_sym);
+
+    if (arg_offset == -1) { //symbol is a local
+        Symbol* sym = get_compiling_frame()->get_symbol_from_scopes(n.m_sym);
+
+        if (!sym) {
+            m_ems.add_error(m_source.line(symbol), "Syntax Error: Variable not declared!");
+            return {Operand::none(), TypeTable::NIL};
+        }
+
+        EmitTacResult r = emit_ir(n.m_a);
+        if (sym->m_type != r.m_type) {
+            m_ems.add_error(m_source.line(symbol), "Type Error: Declaration type and assigned value type don't match!");
+            return {Operand::none(), TypeTable::NIL};
+        }
+
+        Operand tac_name = Operand::var(sym->m_tac_name);
+        emit(TacQuad(tac_name, r.m_temp, Operand::none(), TacT::Assign));
+
+        return {tac_name, r.m_type};
+    } else { //symbol is a formal parameter
+        EmitTacResult r = emit_ir(n.m_a);
+        Symbol* sym = get_compiling_frame()->get_symbol_from_frame(n.m_sym);
+
+        if (sym->m_type != r.m_type) {
+            m_ems.add_error(m_source.line(symbol), "Type Error: Formal parameter type and assigned value type don't match!");
+            return {Operand::none(), TypeTable::NIL};
+        }
+
+        Operand name = Operand::var(sym->m_name);
+        emit(TacQuad(name, r.m_temp, Operand::none(), TacT::Assign));
+        return {name, r.m_type};
+    }
+}
+
+EmitTacResult Semant::emit_block(const AstNode& n) {
+    get_compiling_frame()->begin_scope();
+
+    const AstId* stmts = m_tree.list(n.m_a);
+    for (uint32_t i = 0; i < n.m_b; i++) {
+        emit_ir(stmts[i]);
+    }
+
+    get_compiling_frame()->end_scope();
+
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_if(const AstNode& n) {
+    EmitTacResult cond_r = emit_ir(n.m_a);
+    if (cond_r.m_type != TypeTable::BOOL) {
+        m_ems.add_error(m_source.line(n.m_t), "Syntax Error: 'if' keyword must be followed by boolean expression.");
+    }
+
+    bool has_else = n.m_c != AST_NONE;
+    Operand true_label = Operand::label(new_label());
+    Operand false_label = Operand::none();
+    Operand end_label = Operand::label(new_label());
+
+    if (has_else) {
+        false_label = Operand::label(new_label());
+        emit(TacQuad(cond_r.m_temp, false_label, true_label, TacT::CondGoto));
+    } else {
+        emit(TacQuad(cond_r.m_temp, end_label, true_label, TacT::CondGoto));
+    }
+
+    add_tac_label(true_label.m_value);
+    emit_ir(n.m_b);
+    if (has_else) {
+        emit(TacQuad(Operand::none(), Operand::none(), end_label, TacT::Goto));
+    }
+
+    if (has_else) {
+        add_tac_label(false_label.m_value);
+        emit_ir(n.m_c);
+        emit(TacQuad(Operand::none(), Operand::none(), end_label, TacT::Goto));
+    }
+    add_tac_label(end_label.m_value);
+
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_while(const AstNode& n) {
+    Operand cond_l = Operand::label(new_label());
+    emit(TacQuad(Operand::none(), Operand::none(), cond_l, TacT::Goto));
+    add_tac_label(cond_l.m_value);
+
+    EmitTacResult cond_r = emit_ir(n.m_a);
+    if (cond_r.m_type != TypeTable::BOOL) {
+        m_ems.add_error(m_source.line(n.m_t), "Type Error: 'while' keyword must be followed by boolean expression.");
+    }
+
+    Operand body_l = Operand::label(new_label());
+    Operand end_l = Operand::label(new_label());
+    emit(TacQuad(cond_r.m_temp, end_l, body_l, TacT::CondGoto));
+
+    add_tac_label(body_l.m_value);
+    emit_ir(n.m_b);
+
+    emit(TacQuad(Operand::none(), Operand::none(), cond_l, TacT::Goto));
+    add_tac_label(end_l.m_value);
+
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_call(const AstNode& n) {
+    struct Token symbol = n.m_t;
+    const Symbol *sym = nullptr;
+
+    //type-check if defined in current translation unit
+    if (!(sym = m_globals.get_symbol(n.m_sym))) {
+        //check if symbol defined in imports
+        for (const ModuleInterface* import: m_imports) {
+            if ((sym = import->m_globals.get_symbol(n.m_sym)))
+                break;
+        }
+
+        if (!sym) {
+            m_ems.add_error(m_source.line(symbol), "Syntax Error: Function '%.*s' not defined.", symbol.len, m_source.start(symbol));
+            return {Operand::none(), TypeTable::NIL};
+        }
+    }
+
+    if (n.m_b != types.param_count(sym->m_type)) {
+        m_ems.add_error(m_source.line(symbol), "Type Error: Argument count does not match formal parameter count.");
+        return {Operand::none(), TypeTable::NIL};
+    }
+
+    const AstId* args = m_tree.list(n.m_a);
+    for (int i = n.m_b - 1; i >= 0; i--) {
+        EmitTacResult r = emit_ir(args[i]);
+        if (r.m_type != types.param(sym->m_type, i)) {
+            m_ems.add_error(m_source.line(symbol), "Type Error: Argument type doesn't match formal parameter type.");
+        }
+        emit(TacQuad(Operand::none(), Operand::none(), r.m_temp, TacT::PushArg));
+    }
+
+    TypeId rtype = types.rtype(sym->m_type);
+    Operand t = Operand::none();
+    if (rtype != TypeTable::NIL) {
+        t = Operand::var(get_compiling_frame()->add_temp(rtype));
+        emit(TacQuad(t, Operand::none(), Operand::fun(n.m_sym), TacT::CallResult));
+    } else {
+        emit(TacQuad(t, Operand::none(), Operand::fun(n.m_sym), TacT::CallNil));
+    }
+
+    emit(TacQuad(Operand::none(), Operand::none(), Operand::imm(n.m_b * 4), TacT::PopArgs));
+
+    return {t, rtype};
+}
+
+EmitTacResult Semant::emit_return(const AstNode& n) {
+    if (m_compiling_fun == AST_NONE) {
+        m_ems.add_error(m_source.line(n.m_t), "Synax Error: 'return' can only be used inside a function definition.");
+        return {Operand::none(), TypeTable::NIL};
+    }
+
+    EmitTacResult r = emit_ir(n.m_a);
+    if (r.m_type != types.primitive((enum TokenType)m_tree[m_compiling_fun].m_aux)) {
+        m_ems.add_error(m_source.line(n.m_t), "Synax Error: return data type does not match function return type.");
+    }
+
+    emit(TacQuad(Operand::none(), Operand::none(), r.m_temp, TacT::Return));
+    return {Operand::none(), TypeTable::NIL};
+}
+
+EmitTacResult Semant::emit_import(const AstNode& n) {
+    const ModuleInterface* import = modules.load(m_source.str(n.m_t) + ".tmd", m_ems);
+    if (import) {
+        m_imports.push_back(import);
+    }
+    return {Operand::none(), TypeTable::NIL};
+}
@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-enum TokenType {
+enum TokenType : uint16_t {
     //@Note: order here is necessary for machine code mapping tables
     T_EAX = 0,
     T_ECX,
@@ -99,13 +99,24 @@ enum TokenType {
     T_SETGE,
     T_SETE,
     T_SETNE,
+    T_LEA,
+    T_SHL,
+    T_SAR,
+    T_SHR,
+
+    T_TOKEN_COUNT
 };
 
+/*
+ * Tokens are offsets into the SourceBuffer they were lexed from.
+ * Text and line numbers are looked up through the buffer when needed.
+ */
 struct Token {
+    uint32_t off;
+    uint16_t len;
     enum TokenType type;
-    char *start;
-    int len; 
-    int line;
 };
 
+static_assert(sizeof(struct Token) == 8, "Token should pack into 8 bytes");
+
 #endif //TMD_TOKEN_H
@@ -0,0 +1,24 @@
+#include "token_stream.hpp"
+#include "error.hpp"
+
+void TokenStream::init(SourceBuffer& source, const KeywordTable& reserved_words, ErrorMsgs& ems) {
+    m_lexer.init(source, reserved_words, ems);
+    m_head = 0;
+    m_ring[0] = m_lexer.next();
+    m_ring[1] = m_lexer.next();
+}
+
+struct Token TokenStream::next_token() {
+    struct Token ret = m_ring[m_head];
+    m_ring[m_head] = m_lexer.next();
+    m_head ^= 1;
+    return ret;
+}
+
+struct Token TokenStream::consume_token(enum TokenType tt) {
+    struct Token t = next_token();
+    if (t.type != tt) {
+        ems().add_error(source().line(t), "Unexpected token!");
+    }
+    return t;
+}
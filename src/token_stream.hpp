@@ -0,0 +1,40 @@
+#ifndef TOKEN_STREAM_HPP
+#define TOKEN_STREAM_HPP
+
+#include "token.hpp"
+#include "lexer.hpp"
+#include "source_buffer.hpp"
+#include "reserved_word.hpp"
+
+/*
+ * Pull-based token source shared by the Tamarind and assembly parsers.
+ * Tokens are lexed on demand into a two-slot ring buffer, which is all the
+ * lookahead the parsers need, so the full token list is never materialized.
+ */
+class TokenStream {
+    private:
+        Lexer m_lexer;
+        struct Token m_ring[2];
+        int m_head = 0;
+    public:
+        void init(SourceBuffer& source, const KeywordTable& reserved_words, ErrorMsgs& ems);
+        const SourceBuffer& source() const {
+            return m_lexer.source();
+        }
+        ErrorMsgs& ems() const {
+            return m_lexer.ems();
+        }
+        struct Token peek_one() const {
+            return m_ring[m_head];
+        }
+        struct Token peek_two() const {
+            return m_ring[m_head ^ 1];
+        }
+        struct Token next_token();
+        struct Token consume_token(enum TokenType tt);
+        bool end_of_tokens() const {
+            return peek_one().type == T_EOF;
+        }
+};
+
+#endif //TOKEN_STREAM_HPP
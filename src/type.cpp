@@ -0,0 +1,38 @@
+#include <mutex>
+
+#include "type.hpp"
+
+TypeTable types;
+
+TypeTable::TypeTable() {
+    intern(T_NIL_TYPE);
+    intern(T_INT_TYPE);
+    intern(T_BOOL_TYPE);
+}
+
+TypeId TypeTable::intern(enum TokenType dtype, TypeId rtype, const std::vector<TypeId>& params) {
+    std::string key;
+    key.append((const char*)&dtype, sizeof(dtype));
+    key.append((const char*)&rtype, sizeof(rtype));
+    key.append((const char*)params.data(), params.size() * sizeof(TypeId));
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        std::unordered_map<std::string, TypeId>::iterator it = m_ids.find(key);
+        if (it != m_ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    std::unordered_map<std::string, TypeId>::iterator it = m_ids.find(key);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+
+    TypeId id = m_types.size();
+    m_types.push_back({dtype, rtype, (uint32_t)m_params.size(), (uint32_t)params.size()});
+    m_params.insert(m_params.end(), params.begin(), params.end());
+    m_ids.insert({key, id});
+    return id;
+}
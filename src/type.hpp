@@ -1,31 +1,75 @@
 #ifndef TYPE_HPP
 #define TYPE_HPP
 
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <shared_mutex>
 #include <vector>
+
 #include "token.hpp"
 
-class Type {
+typedef uint32_t TypeId;
+
+/*
+ * One distinct type. Function types (m_dtype == T_FUN_TYPE) also have a return type
+ * and a (first, count) range of parameter types in TypeTable::m_params.
+ */
+struct TypeInfo {
+    enum TokenType m_dtype;
+    TypeId m_rtype;
+    uint32_t m_first_param;
+    uint32_t m_param_count;
+};
+
+/*
+ * Hash-consed table of every type seen in the build. Each distinct type is stored once,
+ * so two types are equal exactly when their ids are.
+ * Shared by modules compiled on different threads, so it is locked like the Interner.
+ */
+class TypeTable {
     public:
-        //if m_dtype == T_FUN_TYPE, then m_rtype and m_params can be used to find function type
-        enum TokenType m_dtype;
-        enum TokenType m_rtype;
-        std::vector<Type> m_ptypes;
+        static constexpr TypeId NIL = 0;
+        static constexpr TypeId INT = 1;
+        static constexpr TypeId BOOL = 2;
+    private:
+        std::vector<TypeInfo> m_types;
+        std::vector<TypeId> m_params;
+        std::unordered_map<std::string, TypeId> m_ids; //key is the type's packed fields and parameter ids
+        mutable std::shared_mutex m_mutex;
     public:
-        Type(enum TokenType dtype, enum TokenType rtype, std::vector<Type> params):
-            m_dtype(dtype), m_rtype(rtype), m_ptypes(params) {}
-        Type(enum TokenType dtype): m_dtype(dtype), m_rtype(T_NIL_TYPE), m_ptypes(std::vector<Type>()) {}
-        bool is_of_type(const Type& other) {
-            if (m_dtype != other.m_dtype) return false;
-            if (m_ptypes.size() != other.m_ptypes.size()) return false;
-
-            if (m_dtype == T_FUN_TYPE) {
-                for (int i = 0; i < int(m_ptypes.size()); i++) {
-                    if (!m_ptypes.at(i).is_of_type(other.m_ptypes.at(i))) return false;
-                }
+        TypeTable();
+        TypeId intern(enum TokenType dtype, TypeId rtype = NIL, const std::vector<TypeId>& params = {});
+        TypeId primitive(enum TokenType dtype) {
+            switch (dtype) {
+                case T_NIL_TYPE: return NIL;
+                case T_INT_TYPE: return INT;
+                case T_BOOL_TYPE: return BOOL;
+                default: return intern(dtype);
             }
-
-            return true;
+        }
+        TypeId function(TypeId rtype, const std::vector<TypeId>& params) {
+            return intern(T_FUN_TYPE, rtype, params);
+        }
+        TypeInfo info(TypeId id) const {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            return m_types[id];
+        }
+        enum TokenType dtype(TypeId id) const {
+            return info(id).m_dtype;
+        }
+        TypeId rtype(TypeId id) const {
+            return info(id).m_rtype;
+        }
+        uint32_t param_count(TypeId id) const {
+            return info(id).m_param_count;
+        }
+        TypeId param(TypeId id, uint32_t i) const {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            return m_params[m_types[id].m_first_param + i];
         }
 };
 
+extern TypeTable types;
+
 #endif //TYPE_HPP
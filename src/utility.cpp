@@ -6,3 +6,13 @@ bool is_int(const std::string s) {
     }
     return s.find_first_not_of("0123456789") == std::string::npos; 
 }
+
+//64-bit FNV-1a
+uint64_t hash_bytes(std::string_view bytes) {
+    uint64_t h = 14695981039346656037ull;
+    for (char c: bytes) {
+        h ^= (uint8_t)c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
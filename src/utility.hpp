@@ -2,7 +2,10 @@
 #define UTILITY_HPP
 
 #include <string>
+#include <string_view>
+#include <cstdint>
 
 bool is_int(const std::string s);
+uint64_t hash_bytes(std::string_view bytes);
 
 #endif //UTILITY_HPP
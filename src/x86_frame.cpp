@@ -4,8 +4,6 @@
 #include "x86_frame.hpp"
 
 
-int X86Frame::s_temp_counter = 0;
-
 void X86Frame::begin_scope() {
     Scope s;
     m_scopes.push_back(s);
@@ -14,7 +12,7 @@ void X86Frame::begin_scope() {
 int X86Frame::end_scope() {
     Scope s = m_scopes.back();
 
-    for (const std::pair<std::string, Symbol>& p: s.m_symbols) {
+    for (const std::pair<const SymbolId, Symbol>& p: s.m_symbols) {
         m_symbols.insert({p.second.m_tac_name, p.second});
     }
 
@@ -23,10 +21,12 @@ int X86Frame::end_scope() {
 }
 
 
-std::string X86Frame::add_local(const std::string& reg_name, Type type) {
+SymbolId X86Frame::add_local(SymbolId reg_name, TypeId type) {
     assert(!symbol_defined_in_current_scope(reg_name));
 
-    std::string tac_name = "_t" + std::to_string((X86Frame::s_temp_counter++)) + reg_name;
+    std::string tac_name = "_t" + std::to_string(m_temp_counter++);
+    tac_name += interner.view(reg_name);
+    SymbolId tac_id = interner.intern(tac_name);
 
     int offset = 0;
     for (const Scope& s: m_scopes) {
@@ -34,46 +34,51 @@ std::string X86Frame::add_local(const std::string& reg_name, Type type) {
     }
 
 
-    m_scopes.back().m_symbols.insert({reg_name == "" ? tac_name : reg_name, Symbol(reg_name, tac_name, type, -4 * (offset + 1))});
+    m_scopes.back().m_symbols.insert({reg_name == Interner::EMPTY ? tac_id : reg_name, Symbol(reg_name, tac_id, type, -4 * (offset + 1))});
 
-    return tac_name;
+    return tac_id;
 }
 
-std::string X86Frame::add_temp(Type type) {
-    return add_local("", type);
+SymbolId X86Frame::add_temp(TypeId type) {
+    return add_local(Interner::EMPTY, type);
 }
 
-bool X86Frame::symbol_defined_in_current_scope(const std::string& name) {
+bool X86Frame::symbol_defined_in_current_scope(SymbolId name) {
     return m_scopes.back().get_symbol(name);
 }
 
-bool X86Frame::add_parameter_to_frame(const std::string& name, Type type, int ord_num) {
-    std::unordered_map<std::string, Symbol>::iterator it = m_symbols.find(name);
+bool X86Frame::add_parameter_to_frame(SymbolId name, TypeId type, int ord_num) {
+    std::unordered_map<SymbolId, Symbol>::iterator it = m_symbols.find(name);
     if (it != m_symbols.end()) {
         return false;
     }
 
-    m_symbols.insert({name, Symbol(name, "", type, 4 * (ord_num + 2))});
+    m_symbols.insert({name, Symbol(name, Interner::EMPTY, type, 4 * (ord_num + 2))});
     return true;
 }
 
-Symbol* X86Frame::get_symbol_from_scopes(const std::string& name) {
+Symbol* X86Frame::get_symbol_from_scopes(SymbolId name) {
 
     for (int i = m_scopes.size() - 1; i >= 0; i--) {
-        std::unordered_map<std::string, Symbol>::iterator it = m_scopes.at(i).m_symbols.find(name);
-
-        if (it == m_scopes.at(i).m_symbols.end()) continue;
-
-        if (it->first == name) {
-            return &(it->second);
-        }        
+        Symbol* sym = m_scopes[i].get_symbol(name);
+        if (sym) {
+            return sym;
+        }
     }
 
     return nullptr;
 }
 
-Symbol* X86Frame::get_symbol_from_frame(const std::string& name) {
-    std::unordered_map<std::string, Symbol>::iterator it = m_symbols.find(name);
+Symbol* X86Frame::get_symbol_from_frame(SymbolId name) {
+    std::unordered_map<SymbolId, Symbol>::iterator it = m_symbols.find(name);
+    if (it == m_symbols.end())
+        return nullptr;
+
+    return &it->second;
+}
+
+const Symbol* X86Frame::get_symbol_from_frame(SymbolId name) const {
+    std::unordered_map<SymbolId, Symbol>::const_iterator it = m_symbols.find(name);
     if (it == m_symbols.end())
         return nullptr;
 
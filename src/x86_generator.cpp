@@ -2,6 +2,7 @@
 #include <stdarg.h>
 #include <iostream>
 #include <unordered_map>
+#include <climits>
 
 #include "x86_generator.hpp"
 #include "utility.hpp"
@@ -18,50 +19,150 @@ void X86Generator::write_op(const char* format, ...) {
     m_buf.insert(m_buf.end(), (uint8_t*)str.data(), (uint8_t*)str.data() + str.size());
 }
 
-void X86Generator::fetch(const std::string& dst, const std::string& src) {
-    if (is_int(src))   write_op("    %s     %s, %s", "mov", dst.c_str(), src.c_str());
-    else               write_op("    %s     %s, [%s + %d]", "mov", dst.c_str(), "ebp", symbol_offset(src));
+void X86Generator::fetch(const char* dst, Operand src) {
+    if (src.is_imm())  write_op("    %s     %s, %d", "mov", dst, src.imm());
+    else               write_op("    %s     %s, [%s + %d]", "mov", dst, "ebp", symbol_offset(src.m_value));
 }
 
 
-void X86Generator::store(const std::string& dst, const std::string& src) {
-    write_op("    %s     [%s + %d], %s", "mov", "ebp", symbol_offset(dst), src.c_str());
+void X86Generator::store(Operand dst, const char* src) {
+    write_op("    %s     [%s + %d], %s", "mov", "ebp", symbol_offset(dst.m_value), src);
 }
 
-int X86Generator::symbol_offset(const std::string& sym_name) {
-    X86Frame current_frame = m_frames->find(m_frame_name)->second;
-    Symbol* sym = current_frame.get_symbol_from_frame(sym_name);
+/*
+ * eax := x * c. Multiplying by c = f * 2^k, f odd, is a shift when f is 1, an lea when f is 3, 5 or 9,
+ * and a shift and an add or subtract when f is 2^j + 1 or 2^j - 1. Those are used when they take at
+ * most two dependent instructions, the latency of one imul; anything else is an imul by an immediate.
+ */
+void X86Generator::multiply(Operand x, int32_t c) {
+    if (c == 0) {
+        write_op("    %s     %s, %d", "mov", "eax", 0);
+        return;
+    }
+    uint32_t m = c < 0 ? 0u - (uint32_t)c : (uint32_t)c;
+    int k = __builtin_ctz(m);
+    uint32_t f = m >> k;
+    bool lea = f == 3 || f == 5 || f == 9;
+    bool add = !lea && f > 1 && ((f - 1) & (f - 2)) == 0; //f - 1 is a power of two
+    bool sub = !lea && f > 1 && (f & (f + 1)) == 0;       //f + 1 is
+    int cost = (f == 1 ? 0 : lea ? 1 : add || sub ? 2 : 3) + (k != 0) + (c < 0);
+
+    if (cost > 2) {
+        if (x.is_imm()) {
+            fetch("eax", x);
+            write_op("    %s    %s, %s, %d", "imul", "eax", "eax", c);
+        } else {
+            write_op("    %s    %s, [%s + %d], %d", "imul", "eax", "ebp", symbol_offset(x.m_value), c);
+        }
+        return;
+    }
+
+    fetch("eax", x);
+    if (lea) {
+        write_op("    %s     %s, [%s + %s*%d]", "lea", "eax", "eax", "eax", f - 1);
+    } else if (add || sub) {
+        write_op("    %s     %s, %s", "mov", "ecx", "eax");
+        write_op("    %s     %s, %d", "shl", "eax", __builtin_ctz(add ? f - 1 : f + 1));
+        write_op("    %s     %s, %s", add ? "add" : "sub", "eax", "ecx");
+    }
+    if (k != 0) write_op("    %s     %s, %d", "shl", "eax", k);
+    if (c < 0)  write_op("    %s     %s", "neg", "eax");
+}
+
+/*
+ * The magic multiplier and shift for signed division by d, which is not -1, 0 or 1
+ * (Hacker's Delight, 10-1): the high half of M * n, corrected by n when M's sign is off
+ * and shifted right by s, is n / d rounded toward minus infinity for n >= 0.
+ */
+static void magic_divisor(int32_t d, int32_t* multiplier, int* shift) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+    uint32_t t = two31 + ((uint32_t)d >> 31);
+    uint32_t anc = t - 1 - t % ad; //absolute value of nc
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    *multiplier = (int32_t)(q2 + 1);
+    if (d < 0) *multiplier = (int32_t)(0u - (q2 + 1));
+    *shift = p - 32;
+}
+
+/*
+ * eax := x / d, truncating, for a constant d other than 0 and INT_MIN.
+ * Powers of two shift, after adding d - 1 to negative dividends so they round toward zero;
+ * other divisors multiply by magic_divisor()'s multiplier and add 1 to negative quotients.
+ */
+void X86Generator::divide(Operand x, int32_t d) {
+    uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+    if (ad == 1) {
+        fetch("eax", x);
+    } else if ((ad & (ad - 1)) == 0) {
+        int k = __builtin_ctz(ad);
+        fetch("eax", x);
+        write_op("    %s     %s, %s", "mov", "edx", "eax");
+        if (k > 1) write_op("    %s     %s, %d", "sar", "edx", 31);
+        write_op("    %s     %s, %d", "shr", "edx", 32 - k);
+        write_op("    %s     %s, %s", "add", "eax", "edx");
+        write_op("    %s     %s, %d", "sar", "eax", k);
+    } else {
+        int32_t multiplier;
+        int shift;
+        magic_divisor(d, &multiplier, &shift);
+        fetch("ecx", x);
+        write_op("    %s     %s, %d", "mov", "eax", multiplier);
+        write_op("    %s    %s", "imul", "ecx");
+        if (d > 0 && multiplier < 0) write_op("    %s     %s, %s", "add", "edx", "ecx");
+        if (d < 0 && multiplier > 0) write_op("    %s     %s, %s", "sub", "edx", "ecx");
+        if (shift != 0) write_op("    %s     %s, %d", "sar", "edx", shift);
+        write_op("    %s     %s, %s", "mov", "eax", "edx");
+        write_op("    %s     %s, %d", "shr", "eax", 31);
+        write_op("    %s     %s, %s", "add", "eax", "edx");
+        return;
+    }
+    if (d < 0) write_op("    %s     %s", "neg", "eax");
+}
+
+int X86Generator::symbol_offset(SymbolId sym_name) {
+    const Symbol* sym = m_frame->get_symbol_from_frame(sym_name);
     return sym->m_fp_offset;
 }
 
 
-void X86Generator::generate_asm(const ControlFlowGraph& cfg,
-                                const std::vector<TacQuad>* quads, 
-                                const std::vector<std::string>* labels, 
-                                const std::unordered_map<std::string, X86Frame>* frames, 
-                                const std::string& output_file) {
+void X86Generator::generate_asm(const TacFunction& fn, const std::unordered_map<SymbolId, X86Frame>* frames) {
 
     m_frames = frames;
 
-    for (const BasicBlock& bb: cfg.m_blocks) {
-        for (int i = bb.m_begin; i < bb.m_end; i++) {
-            TacQuad q = (*quads)[i];
-
-            if ((*labels)[i] != "") {
-                write_op("%s:", (*labels)[i].c_str());
-            }
+    for (const TacBlock& b: fn.m_blocks) {
+        write_op("%s:", interner.c_str(b.m_label));
 
-            if (q.m_op == TacT::EmptyQuad) {
-                continue;
-            }
+        for (InstrId i = b.m_first; i != INSTR_NONE; i = fn.next(i)) {
+            const TacQuad& q = fn.quad(i);
 
             switch (q.m_op) {
                 case TacT::CondGoto:
-                    fetch("eax", q.m_target);
+                    fetch("eax", q.target());
                     write_op("    %s     %s, %s", "cmp", "eax", "0");
-                    write_op("    %s      %s", "je", q.m_opd1.c_str());
-                    if (q.m_opd2 != "") {
-                        write_op("    %s     %s", "jmp", q.m_opd2.c_str());
+                    write_op("    %s      %s", "je", interner.c_str(q.m_values[TacQuad::OPD1]));
+                    if (!q.opd2().is_none()) {
+                        write_op("    %s     %s", "jmp", interner.c_str(q.m_values[TacQuad::OPD2]));
                     }
                     break;
                 case TacT::Entry:
@@ -73,99 +174,110 @@ void X86Generator::generate_asm(const ControlFlowGraph& cfg,
                     write_op("    %s     %s", "int", "0x80");
                     break;
                 case TacT::FunBegin:
-                    m_frame_name = (*labels)[i];
-                    m_frame_size = q.m_opd2;
+                    m_frame = &m_frames->find(fn.m_name)->second;
+                    m_frame_size = q.opd2().imm();
                     write_op("    %s    %s", "push", "ebp");
                     write_op("    %s     %s, %s", "mov", "ebp", "esp");
-                    write_op("    %s     %s, %s", "sub", "esp", q.m_opd2.c_str());
+                    write_op("    %s     %s, %d", "sub", "esp", m_frame_size);
                     break;
                 case TacT::FunEnd:
-                    m_frame_name = "";
-                    m_frame_size = "";
+                    m_frame = nullptr;
+                    m_frame_size = 0;
                     break;
                 case TacT::PushArg:
-                    if (is_int(q.m_opd2)) {
-                        write_op("    %s    %s", "push", q.m_opd2.c_str());
+                    if (q.opd2().is_imm()) {
+                        write_op("    %s    %d", "push", q.opd2().imm());
                     } else {
-                        fetch("eax", q.m_opd2);
+                        fetch("eax", q.opd2());
                         write_op("    %s    %s", "push", "eax");
                     }
                     break;
                 case TacT::PopArgs:
-                    write_op("    %s     %s, %s", "add", "esp", q.m_opd2.c_str());
+                    write_op("    %s     %s, %d", "add", "esp", q.opd2().imm());
                     break;
                 case TacT::CallNil:
-                    write_op("    %s    %s", "call", q.m_opd2.c_str());
+                    write_op("    %s    %s", "call", interner.c_str(q.m_values[TacQuad::OPD2]));
                     break;
                 case TacT::CallResult:
-                    write_op("    %s    %s", q.m_opd1.c_str(), q.m_opd2.c_str());
-                    store(q.m_target, "eax");
+                    write_op("    %s    %s", "call", interner.c_str(q.m_values[TacQuad::OPD2]));
+                    store(q.target(), "eax");
                     break;
                 case TacT::Assign:
-                    fetch("eax", q.m_opd1);
-                    store(q.m_target, "eax");
+                    fetch("eax", q.opd1());
+                    store(q.target(), "eax");
                     break;
                 case TacT::Goto:
-                    write_op("    %s     %s", "jmp", q.m_opd2.c_str());
+                    write_op("    %s     %s", "jmp", interner.c_str(q.m_values[TacQuad::OPD2]));
                     break;
                 case TacT::Return:
-                    fetch("eax", q.m_opd2);
-                    write_op("    %s     %s, %s", "add", "esp", m_frame_size.c_str());
+                    fetch("eax", q.opd2());
+                    write_op("    %s     %s, %d", "add", "esp", m_frame_size);
                     write_op("    %s     %s", "pop", "ebp");
                     write_op("    %s", "ret");
                     break;
                 case TacT::Plus:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
+                    fetch("eax", q.opd1());
+                    fetch("ecx", q.opd2());
                     write_op("    %s     %s, %s", "add", "eax", "ecx");
-                    store(q.m_target, "eax");
+                    store(q.target(), "eax");
                     break;
                 case TacT::Minus:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
+                    fetch("eax", q.opd1());
+                    fetch("ecx", q.opd2());
                     write_op("    %s     %s, %s", "sub", "eax", "ecx");
-                    store(q.m_target, "eax");
+                    store(q.target(), "eax");
                     break;
                 case TacT::Star:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
-                    write_op("    %s    %s, %s", "imul", "eax", "ecx");
-                    store(q.m_target, "eax");
+                    if (q.opd2().is_imm()) {
+                        multiply(q.opd1(), q.opd2().imm());
+                    } else if (q.opd1().is_imm()) {
+                        multiply(q.opd2(), q.opd1().imm());
+                    } else {
+                        fetch("eax", q.opd1());
+                        fetch("ecx", q.opd2());
+                        write_op("    %s    %s, %s", "imul", "eax", "ecx");
+                    }
+                    store(q.target(), "eax");
                     break;
                 case TacT::Slash:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
-                    write_op("    %s", "cdq");
-                    write_op("    %s    %s", "idiv", "ecx");
-                    store(q.m_target, "eax");
+                    //dividing by 0 has to fault at run time, and -INT_MIN doesn't fit
+                    if (q.opd2().is_imm() && q.opd2().imm() != 0 && q.opd2().imm() != INT_MIN) {
+                        divide(q.opd1(), q.opd2().imm());
+                    } else {
+                        fetch("eax", q.opd1());
+                        fetch("ecx", q.opd2());
+                        write_op("    %s", "cdq");
+                        write_op("    %s    %s", "idiv", "ecx");
+                    }
+                    store(q.target(), "eax");
                     break;
                 case TacT::Less:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
+                    fetch("eax", q.opd1());
+                    fetch("ecx", q.opd2());
                     write_op("    %s     %s, %s", "cmp", "eax", "ecx");
                     write_op("    %s    %s", "setl", "al");
                     write_op("    %s   %s, %s", "movzx", "eax", "al");
-                    store(q.m_target, "eax");
+                    store(q.target(), "eax");
                     break;
                 case TacT::EqualEqual:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
+                    fetch("eax", q.opd1());
+                    fetch("ecx", q.opd2());
                     write_op("    %s     %s, %s", "cmp", "eax", "ecx");
                     write_op("    %s    %s", "sete", "al");
                     write_op("    %s   %s, %s", "movzx", "eax", "al");
-                    store(q.m_target, "eax");
+                    store(q.target(), "eax");
                     break;
                 case TacT::And:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
+                    fetch("eax", q.opd1());
+                    fetch("ecx", q.opd2());
                     write_op("    %s     %s, %s", "and", "eax", "ecx");
-                    store(q.m_target, "eax");
+                    store(q.target(), "eax");
                     break;
                 case TacT::Or:
-                    fetch("eax", q.m_opd1);
-                    fetch("ecx", q.m_opd2);
+                    fetch("eax", q.opd1());
+                    fetch("ecx", q.opd2());
                     write_op("    %s      %s, %s", "or", "eax", "ecx");
-                    store(q.m_target, "eax");
+                    store(q.target(), "eax");
                     break;
                 default:
                     write_op("<not implemented>");
@@ -175,8 +287,6 @@ void X86Generator::generate_asm(const ControlFlowGraph& cfg,
             
         }
     }
-
-    write(output_file);
 }
 
 
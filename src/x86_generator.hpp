@@ -5,21 +5,23 @@
 #include <unordered_map>
 #include "tac.hpp"
 #include "x86_frame.hpp"
-#include "ControlFlowGraph.hpp"
 
 class X86Generator {
     public:
         std::vector<uint8_t> m_buf;
-        std::string m_frame_name = "";
-        std::string m_frame_size = "";
-        const std::unordered_map<std::string, X86Frame>* m_frames;
+        const X86Frame* m_frame = nullptr; //frame of the function being generated
+        int m_frame_size = 0;
+        const std::unordered_map<SymbolId, X86Frame>* m_frames;
     public:
-        int symbol_offset(const std::string& sym_name);
+        int symbol_offset(SymbolId sym_name);
         void write_op(const char* format, ...);
-        void generate_asm(const ControlFlowGraph& cfg, const std::vector<TacQuad>* quads, const std::vector<std::string>* labels, const std::unordered_map<std::string, X86Frame>* frames, const std::string& output_file);
+        //lowers one function, so functions can be generated on separate threads
+        void generate_asm(const TacFunction& fn, const std::unordered_map<SymbolId, X86Frame>* frames);
         void write(const std::string& output_file);
-        void fetch(const std::string& dst, const std::string& src);
-        void store(const std::string& dst, const std::string& src);
+        void fetch(const char* dst, Operand src);
+        void store(Operand dst, const char* src);
+        void multiply(Operand x, int32_t c);
+        void divide(Operand x, int32_t d);
 };
 
 #endif //X86_GENERATOR_HPP
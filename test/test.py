@@ -1,21 +1,32 @@
+import os
 import subprocess
+import sys
+import tempfile
+
+#usage: python3 test.py [path to tama], run from any directory
+here = os.path.dirname(os.path.abspath(__file__))
+tama = os.path.abspath(sys.argv[1]) if len(sys.argv) > 1 else os.path.join(here, "..", "build", "src", "tama")
 
 global correct
 correct = 0
 
 def test(data):
-    for src in data[2]:
-        with open(src[0], "w") as f:
-            f.write(src[1].strip())
+    #each test compiles in its own scratch directory, so the .tmd files checked in next to this script are left alone
+    with tempfile.TemporaryDirectory() as work:
+        for src in data[2]:
+            with open(os.path.join(work, src[0]), "w") as f:
+                f.write(src[1].strip())
 
-    cmd = "./../build/src/tama"
-    for src in data[2]:
-        cmd += " " + src[0]
-    cmd += " > /dev/null"
+        cmd = tama
+        for src in data[2]:
+            cmd += " " + src[0]
+        cmd += " > /dev/null"
 
-    cp = subprocess.call(cmd, shell=True)
-    subprocess.call("chmod +x out.exe", shell=True)
-    p = subprocess.call("./out.exe", shell=True)
+        cp = subprocess.call(cmd, shell=True, cwd=work)
+        p = None
+        if cp == 0:
+            subprocess.call("chmod +x out.exe", shell=True, cwd=work)
+            p = subprocess.call("./out.exe", shell=True, cwd=work)
 
     name = "[" + data[0] + "]"
     result = "Failed"
@@ -23,35 +34,32 @@ def test(data):
         result = "Passed"
         global correct
         correct += 1
+    elif cp != 0:
+        result = "Failed (compiler exited with " + str(cp) + ")"
+    else:
+        result = "Failed (got " + str(p) + ", expected " + str(data[1]) + ")"
 
     print(name.ljust(40, " "), result)
 
-    #cleanup
-    for src in data[2]:
-        subprocess.call("rm " + src[0], shell=True)
-        subprocess.call("rm " + src[0][:-4] + ".asm", shell=True)
-        subprocess.call("rm " + src[0][:-4] + ".obj", shell=True)
-
-    subprocess.call("rm out.exe", shell=True)
-
 
+#expected values are exit codes as the shell reports them: 128 plus the signal for a program that was killed (136 is SIGFPE)
 tests = [
             ("return code", 0,
                 [
                     ("main.tmd",
                         """
-                        main: () -> int {
+                        main :: () -> int {
                             return 0
                         }
                         """
                     )
                 ]
             ),
-            ("sign integer arithmetic", 0, 
+            ("sign integer arithmetic", 0,
                 [
                     ("main.tmd",
                          """
-                         main: () -> int {
+                         main :: () -> int {
                             x: int = 10
                             y: int = 10
                             return -100 + x * y - x + y - y / x + x / y
@@ -64,7 +72,7 @@ tests = [
                 [
                     ("main.tmd",
                          """
-                         main: () -> int {
+                         main :: () -> int {
                             if true {
                                 return 0
                             } else {
@@ -75,24 +83,25 @@ tests = [
                     )
                 ]
             ),
-            ("boolean operators", 0, 
+            ("boolean operators", 0,
                 [
                     ("main.tmd",
                         """
-                        main: () -> int {
+                        main :: () -> int {
                             if (true or false) and true {
                                 return 0
                             }
+                            return 1
                         }
                         """
                     )
                 ]
             ),
-            ("while loops", 0, 
+            ("while loops", 0,
                 [
                     ("main.tmd",
                          """
-                         main: () -> int {
+                         main :: () -> int {
                                 x: int = 9
                                 while x > 0 {
                                     x = x - 1
@@ -103,16 +112,16 @@ tests = [
                     )
                 ]
             ),
-            ("functions", 0, 
+            ("functions", 0,
                 [
                     ("main.tmd",
                          """
-                         add: (a: int, b: int) -> int {
+                         sum :: (a: int, b: int) -> int {
                                 return a + b
                             }
 
-                            main: () -> int {
-                                return add(-10, 10)
+                            main :: () -> int {
+                                return sum(-10, 10)
                             }
                           """
                     )
@@ -120,23 +129,402 @@ tests = [
             ),
             ("module import", 0,
                 [
-                    ("main.tmd", 
+                    ("main.tmd",
                         """
                         import math
-                        main: () -> int {
-                            return add(-10, 10)
+                        main :: () -> int {
+                            return sum(-10, 10)
                         }
                         """
                     ),
                     ("math.tmd",
                         """
-                        add: (a: int, b: int) -> int {
+                        sum :: (a: int, b: int) -> int {
                         return a + b
                         }
                         """
                     ),
                 ]
             ),
+            ("sccp constant condition", 0,
+                [
+                    ("main.tmd",
+                        """
+                        main :: () -> int {
+                            x: int = 6
+                            y: int = x * 7
+                            if y == 42 {
+                                return 0
+                            }
+                            return 1
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("sccp unreachable blocks", 0,
+                [
+                    ("main.tmd",
+                        """
+                        pick :: (a: int) -> int {
+                            r: int = 5
+                            if false {
+                                r = a
+                            }
+                            while r < 0 {
+                                r = r + a
+                            }
+                            return r * a
+                        }
+
+                        main :: () -> int {
+                            return pick(8) - 40
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("sccp constant through branches", 0,
+                [
+                    ("main.tmd",
+                        """
+                        scale :: (a: int) -> int {
+                            k: int = 0
+                            if a > 0 {
+                                k = 3
+                            } else {
+                                k = 3
+                            }
+                            return a * k
+                        }
+
+                        main :: () -> int {
+                            if scale(4) != 12 or scale(-4) != -12 {
+                                return 1
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("constant division by zero traps", 136,
+                [
+                    ("main.tmd",
+                        """
+                        main :: () -> int {
+                            x: int = 7
+                            y: int = 0
+                            return x / y
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("gvn redundant across blocks", 0,
+                [
+                    ("main.tmd",
+                        """
+                        mix :: (a: int, b: int, c: int) -> int {
+                            x: int = a * b + c
+                            r: int = 0
+                            if c > 0 {
+                                r = a * b + c
+                            } else {
+                                r = b - a
+                            }
+                            s: int = b - a
+                            return x + r + s
+                        }
+
+                        main :: () -> int {
+                            if mix(3, 5, 1) != 34 or mix(3, 5, -1) != 18 or mix(2, 9, 0) != 32 {
+                                return 1
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("gvn commutative operands", 0,
+                [
+                    ("main.tmd",
+                        """
+                        both :: (a: int, b: int) -> int {
+                            c: int = a * b + a * b
+                            d: int = b * a
+                            return c + d - (a + b) + (b + a)
+                        }
+
+                        main :: () -> int {
+                            if both(3, 5) != 45 or both(-2, 7) != -42 {
+                                return 1
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("licm zero-trip loop", 0,
+                [
+                    ("main.tmd",
+                        """
+                        repeat :: (n: int, k: int) -> int {
+                            i: int = 0
+                            s: int = 0
+                            while i < n {
+                                t: int = k * 2 + 1
+                                u: int = 100 / k
+                                s = s + t + u
+                                i = i + 1
+                            }
+                            return s
+                        }
+
+                        main :: () -> int {
+                            if repeat(0, 0) != 0 or repeat(0, 5) != 0 or repeat(3, 5) != 93 {
+                                return 1
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("licm nested loops", 0,
+                [
+                    ("main.tmd",
+                        """
+                        grid :: (n: int, k: int) -> int {
+                            i: int = 0
+                            s: int = 0
+                            while i < n * k {
+                                j: int = 0
+                                while j < n {
+                                    s = s + i * k + j / 4
+                                    j = j + 1
+                                }
+                                i = i + 1
+                            }
+                            return s
+                        }
+
+                        main :: () -> int {
+                            if grid(3, 2) != 90 or grid(0, 7) != 0 or grid(5, 1) != 55 {
+                                return 1
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("constant divisors", 0,
+                [
+                    ("main.tmd",
+                        """
+                        third :: (x: int) -> int {
+                            return x / 3
+                        }
+
+                        seventh :: (x: int) -> int {
+                            return x / 7
+                        }
+
+                        neg_third :: (x: int) -> int {
+                            return x / -3
+                        }
+
+                        neg_seventh :: (x: int) -> int {
+                            return x / -7
+                        }
+
+                        half :: (x: int) -> int {
+                            return x / 2
+                        }
+
+                        neg_half :: (x: int) -> int {
+                            return x / -2
+                        }
+
+                        sixteenth :: (x: int) -> int {
+                            return x / 16
+                        }
+
+                        neg_eighth :: (x: int) -> int {
+                            return x / -8
+                        }
+
+                        one :: (x: int) -> int {
+                            return x / 1
+                        }
+
+                        neg_one :: (x: int) -> int {
+                            return x / -1
+                        }
+
+                        by_min :: (x: int) -> int {
+                            return x / (-2147483647 - 1)
+                        }
+
+                        main :: () -> int {
+                            if third(100) != 33 or third(-100) != -33 or third(2147483647) != 715827882 or third(-2147483647 - 1) != -715827882 {
+                                return 1
+                            }
+                            if seventh(100) != 14 or seventh(-100) != -14 or seventh(2147483647) != 306783378 or seventh(-2147483647 - 1) != -306783378 {
+                                return 2
+                            }
+                            if neg_third(100) != -33 or neg_third(-100) != 33 or neg_third(2147483647) != -715827882 or neg_third(-2147483647 - 1) != 715827882 {
+                                return 3
+                            }
+                            if neg_seventh(100) != -14 or neg_seventh(-100) != 14 or neg_seventh(2147483647) != -306783378 or neg_seventh(-2147483647 - 1) != 306783378 {
+                                return 4
+                            }
+                            if half(100) != 50 or half(-100) != -50 or half(2147483647) != 1073741823 or half(-2147483647 - 1) != -1073741824 {
+                                return 5
+                            }
+                            if neg_half(100) != -50 or neg_half(-100) != 50 or neg_half(2147483647) != -1073741823 or neg_half(-2147483647 - 1) != 1073741824 {
+                                return 6
+                            }
+                            if sixteenth(100) != 6 or sixteenth(-100) != -6 or sixteenth(2147483647) != 134217727 or sixteenth(-2147483647 - 1) != -134217728 {
+                                return 7
+                            }
+                            if neg_eighth(100) != -12 or neg_eighth(-100) != 12 or neg_eighth(2147483647) != -268435455 or neg_eighth(-2147483647 - 1) != 268435456 {
+                                return 8
+                            }
+                            if one(100) != 100 or one(-100) != -100 or one(2147483647) != 2147483647 or one(-2147483647 - 1) != (-2147483647 - 1) {
+                                return 9
+                            }
+                            if neg_one(100) != -100 or neg_one(-100) != 100 or neg_one(2147483647) != -2147483647 {
+                                return 10
+                            }
+                            if by_min(100) != 0 or by_min(-100) != 0 or by_min(2147483647) != 0 or by_min(-2147483647 - 1) != 1 {
+                                return 11
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("constant multipliers", 0,
+                [
+                    ("main.tmd",
+                        """
+                        zero :: (x: int) -> int {
+                            return x * 0
+                        }
+
+                        negate :: (x: int) -> int {
+                            return x * -1
+                        }
+
+                        triple :: (x: int) -> int {
+                            return x * 3
+                        }
+
+                        five :: (x: int) -> int {
+                            return x * 5
+                        }
+
+                        nine :: (x: int) -> int {
+                            return x * 9
+                        }
+
+                        seven :: (x: int) -> int {
+                            return x * 7
+                        }
+
+                        fifteen :: (x: int) -> int {
+                            return x * 15
+                        }
+
+                        by_min :: (x: int) -> int {
+                            return x * (-2147483647 - 1)
+                        }
+
+                        main :: () -> int {
+                            if zero(100) != 0 or zero(-100) != 0 or zero(12345) != 0 or zero(-2147483647 - 1) != 0 {
+                                return 1
+                            }
+                            if negate(100) != -100 or negate(-100) != 100 or negate(12345) != -12345 {
+                                return 2
+                            }
+                            if triple(100) != 300 or triple(-100) != -300 or triple(12345) != 37035 or triple(-2147483647 - 1) != (-2147483647 - 1) {
+                                return 3
+                            }
+                            if five(100) != 500 or five(-100) != -500 or five(12345) != 61725 or five(-2147483647 - 1) != (-2147483647 - 1) {
+                                return 4
+                            }
+                            if nine(100) != 900 or nine(-100) != -900 or nine(12345) != 111105 or nine(-2147483647 - 1) != (-2147483647 - 1) {
+                                return 5
+                            }
+                            if seven(100) != 700 or seven(-100) != -700 or seven(12345) != 86415 or seven(-2147483647 - 1) != (-2147483647 - 1) {
+                                return 6
+                            }
+                            if fifteen(100) != 1500 or fifteen(-100) != -1500 or fifteen(12345) != 185175 or fifteen(-2147483647 - 1) != (-2147483647 - 1) {
+                                return 7
+                            }
+                            if by_min(100) != 0 or by_min(-100) != 0 or by_min(12345) != (-2147483647 - 1) or by_min(-2147483647 - 1) != 0 {
+                                return 8
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("constant divisor zero traps", 136,
+                [
+                    ("main.tmd",
+                        """
+                        zero :: (x: int) -> int {
+                            return x / 0
+                        }
+
+                        main :: () -> int {
+                            return zero(5)
+                        }
+                        """
+                    )
+                ]
+            ),
+            ("induction variable multiplies", 0,
+                [
+                    ("main.tmd",
+                        """
+                        evens :: (n: int) -> int {
+                            i: int = 0
+                            s: int = 0
+                            while i < n {
+                                s = s + i * 5
+                                i = i + 2
+                            }
+                            return s
+                        }
+
+                        countdown :: (n: int) -> int {
+                            i: int = n
+                            s: int = 0
+                            while i > 0 {
+                                s = s + 7 * i - i * -3
+                                i = i - 1
+                            }
+                            return s
+                        }
+
+                        main :: () -> int {
+                            if evens(10) != 100 or evens(0) != 0 or countdown(5) != 150 or countdown(-1) != 0 {
+                                return 1
+                            }
+                            return 0
+                        }
+                        """
+                    )
+                ]
+            ),
         ]
 
 
@@ -146,3 +534,4 @@ for data in tests:
     test(data)
 
 print("Tests passed:", correct, "/", len(tests))
+sys.exit(0 if correct == len(tests) else 1)